@@ -16,53 +16,63 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <Urho3D/Container/Str.h>
 
+#include <cstddef>
+
+// bulk kernels, x86 ones are compiled with target attributes and picked at runtime so no special build flags are needed
+#if !defined(__EMSCRIPTEN__) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+    #define BASE64_X86
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+    #include <immintrin.h>
+    #if defined(__GNUC__) || defined(__clang__)
+        #define BASE64_TARGET(isa) __attribute__((target(isa)))
+    #else
+        #define BASE64_TARGET(isa)
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define BASE64_NEON
+    #include <arm_neon.h>
+#endif
+
 const char kBase64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
 "abcdefghijklmnopqrstuvwxyz"
 "0123456789+/";
 
 class Base64 {
 public:
-    static bool Encode(const Urho3D::String &in, Urho3D::String* out) {
-        int i = 0, j = 0;
-        size_t enc_len = 0;
-        unsigned char a3[3];
-        unsigned char a4[4];
-
-        out->Resize(EncodedLength(in));
-
-        int input_len = in.Length();
-        Urho3D::String::ConstIterator input = in.Begin();
-
-        while (input_len--) {
-            a3[i++] = *(input++);
-            if (i == 3) {
-                a3_to_a4(a4, a3);
-
-                for (i = 0; i < 4; i++) {
-                    (*out)[enc_len++] = kBase64Alphabet[a4[i]];
-                }
-
-                i = 0;
-            }
-        }
-
-        if (i) {
-            for (j = i; j < 3; j++) {
-                a3[j] = '\0';
-            }
-
-            a3_to_a4(a4, a3);
-
-            for (j = 0; j < i + 1; j++) {
-                (*out)[enc_len++] = kBase64Alphabet[a4[j]];
-            }
-
-            while ((i++ < 3)) {
-                (*out)[enc_len++] = '=';
-            }
+    /// Bulk kernels, the fastest one the CPU supports is picked on first use.
+    enum Kernel {
+        KERNEL_SCALAR = 0,
+        KERNEL_SSSE3,
+        KERNEL_AVX2,
+        KERNEL_NEON
+    };
+
+    /// Returns the kernel in use.
+    static Kernel GetKernel() { return ActiveKernel(); }
+    /// Returns true if the CPU can run the kernel.
+    static bool IsSupported(Kernel kernel) { return (SupportedKernels() & (1u << kernel)) != 0; }
+    /// Forces a kernel (ie. to compare them), returns false if it isn't supported. Not thread-safe, call before encoding.
+    static bool SetKernel(Kernel kernel) {
+        if (!IsSupported(kernel)) return false;
+        ActiveKernel() = kernel;
+        return true;
+    }
+    static const char* GetKernelName(Kernel kernel) {
+        switch (kernel) {
+        case KERNEL_SSSE3: return "SSSE3";
+        case KERNEL_AVX2: return "AVX2";
+        case KERNEL_NEON: return "NEON";
+        default: return "Scalar";
         }
+    }
 
-        return (enc_len == out->Length());
+    static bool Encode(const Urho3D::String &in, Urho3D::String* out) {
+        out->Resize(EncodedLength(in));
+        if (in.Empty())
+            return true;
+        return Encode(in.CString(), in.Length(), &(*out)[0], out->Length());
     }
 
     static bool Encode(const char *input, size_t input_length, char *out, size_t out_length) {
@@ -75,6 +85,12 @@ public:
 
         if (out_length < encoded_length) return false;
 
+        // whole blocks go through the vector kernel, the remainder and padding through the byte loop
+        size_t bulk = EncodeBulk((const unsigned char*)input, input_length, out);
+        input += bulk;
+        input_length -= bulk;
+        out += bulk / 3 * 4;
+
         while (input_length--) {
             a3[i++] = *input++;
             if (i == 3) {
@@ -107,55 +123,36 @@ public:
         return (out == (out_begin + encoded_length));
     }
 
-    static bool Decode(const Urho3D::String &in, Urho3D::String* out) {
-        int i = 0, j = 0;
-        size_t dec_len = 0;
-        unsigned char a3[3];
-        unsigned char a4[4];
-
-        int input_len = in.Length();
-        Urho3D::String::ConstIterator input = in.Begin();
-
-        out->Resize(DecodedLength(in));
-
-        while (input_len--) {
-            if (*input == '=') {
-                break;
-            }
-
-            a4[i++] = *(input++);
-            if (i == 4) {
-                for (i = 0; i <4; i++) {
-                    a4[i] = b64_lookup(a4[i]);
-                }
-
-                a4_to_a3(a3, a4);
-
-                for (i = 0; i < 3; i++) {
-                    (*out)[dec_len++] = a3[i];
-                }
-
-                i = 0;
-            }
+    /// Encodes straight into a sink with a Write(const void*, unsigned) method (ie. a DevServerResponse) through a fixed stack buffer,
+    /// so large inputs never need the whole encoded text in memory.
+    template<typename Sink>
+    static void EncodeTo(const void *input, size_t input_length, Sink& sink) {
+        const size_t CHUNK_INPUT = 12 * 1024;
+        char block[CHUNK_INPUT / 3 * 4];
+
+        const char* in = (const char*)input;
+        while (input_length > CHUNK_INPUT) {
+            // a multiple of 3 so only the last chunk carries padding
+            Encode(in, CHUNK_INPUT, block, sizeof(block));
+            sink.Write(block, (unsigned)sizeof(block));
+            in += CHUNK_INPUT;
+            input_length -= CHUNK_INPUT;
         }
 
-        if (i) {
-            for (j = i; j < 4; j++) {
-                a4[j] = '\0';
-            }
-
-            for (j = 0; j < 4; j++) {
-                a4[j] = b64_lookup(a4[j]);
-            }
-
-            a4_to_a3(a3, a4);
+        const size_t encoded_length = EncodedLength(input_length);
+        Encode(in, input_length, block, encoded_length);
+        sink.Write(block, (unsigned)encoded_length);
+    }
 
-            for (j = 0; j < i - 1; j++) {
-                (*out)[dec_len++] = a3[j];
-            }
+    static bool Decode(const Urho3D::String &in, Urho3D::String* out) {
+        if (in.Empty()) {
+            out->Clear();
+            return true;
         }
-
-        return (dec_len == out->Length());
+        out->Resize(DecodedLength(in));
+        if (out->Empty())
+            return true;
+        return Decode(in.CString(), in.Length(), &(*out)[0], out->Length());
     }
 
     static bool Decode(const char *input, size_t input_length, char *out, size_t out_length) {
@@ -168,6 +165,12 @@ public:
 
         if (out_length < decoded_length) return false;
 
+        // the kernels stop at the first block holding padding or anything outside the alphabet
+        size_t bulk = DecodeBulk(input, input_length, (unsigned char*)out, out_length);
+        input += bulk;
+        input_length -= bulk;
+        out += bulk / 4 * 3;
+
         while (input_length--) {
             if (*input == '=') {
                 break;
@@ -212,7 +215,7 @@ public:
         int numEq = 0;
 
         const char *in_end = in + in_length;
-        while (*--in_end == '=') ++numEq;
+        while (in_end > in && *--in_end == '=') ++numEq;
 
         return ((6 * in_length) / 8) - numEq;
     }
@@ -266,4 +269,268 @@ private:
         if (c == '/') return 63;
         return 255;
     }
+
+    /// Bit per Kernel the CPU can run.
+    static unsigned SupportedKernels() {
+        static const unsigned supported = DetectKernels();
+        return supported;
+    }
+
+    static Kernel& ActiveKernel() {
+        static Kernel kernel = SupportedKernels() & (1u << KERNEL_AVX2) ? KERNEL_AVX2 :
+            SupportedKernels() & (1u << KERNEL_SSSE3) ? KERNEL_SSSE3 :
+            SupportedKernels() & (1u << KERNEL_NEON) ? KERNEL_NEON : KERNEL_SCALAR;
+        return kernel;
+    }
+
+    static unsigned DetectKernels() {
+        unsigned kernels = 1u << KERNEL_SCALAR;
+#if defined(BASE64_X86)
+    #if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool ssse3 = (info[2] & (1 << 9)) != 0;
+        // AVX state must be enabled by the OS as well
+        const bool avxState = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+        bool avx2 = false;
+        if (maxLeaf >= 7 && avxState) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+    #else
+        __builtin_cpu_init();
+        const bool ssse3 = __builtin_cpu_supports("ssse3") != 0;
+        const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+    #endif
+        if (ssse3) kernels |= 1u << KERNEL_SSSE3;
+        if (avx2) kernels |= 1u << KERNEL_AVX2;
+#elif defined(BASE64_NEON)
+        kernels |= 1u << KERNEL_NEON;
+#endif
+        return kernels;
+    }
+
+    /// Encodes whole blocks with the active kernel, returns the input bytes consumed (a multiple of 3).
+    static size_t EncodeBulk(const unsigned char* in, size_t length, char* out) {
+        switch (ActiveKernel()) {
+#if defined(BASE64_X86)
+        case KERNEL_AVX2: return EncodeAVX2(in, length, out);
+        case KERNEL_SSSE3: return EncodeSSSE3(in, length, out);
+#elif defined(BASE64_NEON)
+        case KERNEL_NEON: return EncodeNEON(in, length, out);
+#endif
+        default: return 0;
+        }
+    }
+
+    /// Decodes whole blocks with the active kernel, returns the input characters consumed (a multiple of 4).
+    static size_t DecodeBulk(const char* in, size_t length, unsigned char* out, size_t out_length) {
+        switch (ActiveKernel()) {
+#if defined(BASE64_X86)
+        case KERNEL_AVX2: return DecodeAVX2(in, length, out, out_length);
+        case KERNEL_SSSE3: return DecodeSSSE3(in, length, out, out_length);
+#elif defined(BASE64_NEON)
+        case KERNEL_NEON: return DecodeNEON(in, length, out, out_length);
+#endif
+        default: return 0;
+        }
+    }
+
+#if defined(BASE64_X86)
+    // Splitting and lookup follow Muła and Lemire, "Faster Base64 Encoding and Decoding Using AVX2 Instructions".
+
+    /// Spreads 12 bytes into 16 six-bit indices.
+    BASE64_TARGET("ssse3") static inline __m128i EncodeSplitSSSE3(__m128i in) {
+        in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        return _mm_or_si128(t1, t3);
+    }
+
+    /// Maps indices to the alphabet by adding a per-range offset.
+    BASE64_TARGET("ssse3") static inline __m128i EncodeLookupSSSE3(__m128i indices) {
+        const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+        return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+    }
+
+    BASE64_TARGET("ssse3") static size_t EncodeSSSE3(const unsigned char* in, size_t length, char* out) {
+        size_t done = 0;
+        // loads 16 bytes to use 12
+        for (; length - done >= 16; done += 12, out += 16) {
+            const __m128i block = _mm_loadu_si128((const __m128i*)(in + done));
+            _mm_storeu_si128((__m128i*)out, EncodeLookupSSSE3(EncodeSplitSSSE3(block)));
+        }
+        return done;
+    }
+
+    /// Turns 16 characters into 6-bit values, returns false if any is outside the alphabet (including padding).
+    BASE64_TARGET("ssse3") static inline bool DecodeLookupSSSE3(__m128i in, __m128i& values) {
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('Z' + 1)));
+        const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('z' + 1)));
+        const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('9' + 1)));
+        const __m128i plus = _mm_cmpeq_epi8(in, _mm_set1_epi8('+'));
+        const __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+        const __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, plus), slash));
+        if (_mm_movemask_epi8(valid) != 0xffff)
+            return false;
+
+        __m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-65));
+        shift = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(-71)));
+        shift = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(4)));
+        shift = _mm_or_si128(shift, _mm_and_si128(plus, _mm_set1_epi8(19)));
+        shift = _mm_or_si128(shift, _mm_and_si128(slash, _mm_set1_epi8(16)));
+        values = _mm_add_epi8(in, shift);
+        return true;
+    }
+
+    /// Packs 16 six-bit values into 12 bytes at the bottom of the register.
+    BASE64_TARGET("ssse3") static inline __m128i DecodePackSSSE3(__m128i values) {
+        const __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        return _mm_shuffle_epi8(quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    }
+
+    BASE64_TARGET("ssse3") static size_t DecodeSSSE3(const char* in, size_t length, unsigned char* out, size_t out_length) {
+        size_t done = 0;
+        // stores 16 bytes to produce 12
+        for (size_t written = 0; length - done >= 16 && out_length - written >= 16; done += 16, written += 12) {
+            __m128i values;
+            if (!DecodeLookupSSSE3(_mm_loadu_si128((const __m128i*)(in + done)), values))
+                break;
+            _mm_storeu_si128((__m128i*)(out + written), DecodePackSSSE3(values));
+        }
+        return done;
+    }
+
+    BASE64_TARGET("avx2") static size_t EncodeAVX2(const unsigned char* in, size_t length, char* out) {
+        const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+        const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+        size_t done = 0;
+        // each lane takes 12 bytes, the second lane's load reaches 28 bytes in
+        for (; length - done >= 28; done += 24, out += 32) {
+            const __m128i lo = _mm_loadu_si128((const __m128i*)(in + done));
+            const __m128i hi = _mm_loadu_si128((const __m128i*)(in + done + 12));
+            __m256i block = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+            block = _mm256_shuffle_epi8(block, shuffle);
+            const __m256i t0 = _mm256_and_si256(block, _mm256_set1_epi32(0x0fc0fc00));
+            const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+            const __m256i t2 = _mm256_and_si256(block, _mm256_set1_epi32(0x003f03f0));
+            const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+            const __m256i indices = _mm256_or_si256(t1, t3);
+
+            __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+            const __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+            range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+            _mm256_storeu_si256((__m256i*)out, _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices));
+        }
+        return done + EncodeSSSE3(in + done, length - done, out);
+    }
+
+    BASE64_TARGET("avx2") static size_t DecodeAVX2(const char* in, size_t length, unsigned char* out, size_t out_length) {
+        const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+        size_t done = 0;
+        size_t written = 0;
+        // the second lane's 16 byte store reaches 28 bytes in
+        for (; length - done >= 32 && out_length - written >= 28; done += 32, written += 24) {
+            const __m256i in32 = _mm256_loadu_si256((const __m256i*)(in + done));
+            const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(in32, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), in32));
+            const __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(in32, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), in32));
+            const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(in32, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), in32));
+            const __m256i plus = _mm256_cmpeq_epi8(in32, _mm256_set1_epi8('+'));
+            const __m256i slash = _mm256_cmpeq_epi8(in32, _mm256_set1_epi8('/'));
+            const __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(_mm256_or_si256(digit, plus), slash));
+            if (_mm256_movemask_epi8(valid) != -1)
+                break;
+
+            __m256i shift = _mm256_and_si256(upper, _mm256_set1_epi8(-65));
+            shift = _mm256_or_si256(shift, _mm256_and_si256(lower, _mm256_set1_epi8(-71)));
+            shift = _mm256_or_si256(shift, _mm256_and_si256(digit, _mm256_set1_epi8(4)));
+            shift = _mm256_or_si256(shift, _mm256_and_si256(plus, _mm256_set1_epi8(19)));
+            shift = _mm256_or_si256(shift, _mm256_and_si256(slash, _mm256_set1_epi8(16)));
+            const __m256i values = _mm256_add_epi8(in32, shift);
+
+            const __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+            const __m256i quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+            const __m256i packed = _mm256_shuffle_epi8(quads, pack);
+            _mm_storeu_si128((__m128i*)(out + written), _mm256_castsi256_si128(packed));
+            _mm_storeu_si128((__m128i*)(out + written + 12), _mm256_extracti128_si256(packed, 1));
+        }
+        return done + DecodeSSSE3(in + done, length - done, out + written, out_length - written);
+    }
+#elif defined(BASE64_NEON)
+    static size_t EncodeNEON(const unsigned char* in, size_t length, char* out) {
+        uint8x16x4_t alphabet;
+        for (int i = 0; i < 4; ++i)
+            alphabet.val[i] = vld1q_u8((const uint8_t*)kBase64Alphabet + i * 16);
+        const uint8x16_t mask = vdupq_n_u8(0x3f);
+
+        size_t done = 0;
+        // the structured load/store deinterleave 3 byte groups and interleave 4 character groups
+        for (; length - done >= 48; done += 48, out += 64) {
+            const uint8x16x3_t src = vld3q_u8(in + done);
+            uint8x16x4_t dst;
+            dst.val[0] = vshrq_n_u8(src.val[0], 2);
+            dst.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(src.val[0], 4), vshrq_n_u8(src.val[1], 4)), mask);
+            dst.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(src.val[1], 2), vshrq_n_u8(src.val[2], 6)), mask);
+            dst.val[3] = vandq_u8(src.val[2], mask);
+            for (int i = 0; i < 4; ++i)
+                dst.val[i] = vqtbl4q_u8(alphabet, dst.val[i]);
+            vst4q_u8((uint8_t*)out, dst);
+        }
+        return done;
+    }
+
+    /// Turns 16 characters into 6-bit values, lanes outside the alphabet are flagged 0xff in invalid.
+    static inline uint8x16_t DecodeLookupNEON(uint8x16_t in, uint8x16_t& invalid) {
+        const uint8x16_t upper = vandq_u8(vcgeq_u8(in, vdupq_n_u8('A')), vcleq_u8(in, vdupq_n_u8('Z')));
+        const uint8x16_t lower = vandq_u8(vcgeq_u8(in, vdupq_n_u8('a')), vcleq_u8(in, vdupq_n_u8('z')));
+        const uint8x16_t digit = vandq_u8(vcgeq_u8(in, vdupq_n_u8('0')), vcleq_u8(in, vdupq_n_u8('9')));
+        const uint8x16_t plus = vceqq_u8(in, vdupq_n_u8('+'));
+        const uint8x16_t slash = vceqq_u8(in, vdupq_n_u8('/'));
+        invalid = vorrq_u8(invalid, vmvnq_u8(vorrq_u8(vorrq_u8(upper, lower), vorrq_u8(vorrq_u8(digit, plus), slash))));
+
+        uint8x16_t shift = vandq_u8(upper, vdupq_n_u8((uint8_t)-65));
+        shift = vorrq_u8(shift, vandq_u8(lower, vdupq_n_u8((uint8_t)-71)));
+        shift = vorrq_u8(shift, vandq_u8(digit, vdupq_n_u8(4)));
+        shift = vorrq_u8(shift, vandq_u8(plus, vdupq_n_u8(19)));
+        shift = vorrq_u8(shift, vandq_u8(slash, vdupq_n_u8(16)));
+        return vaddq_u8(in, shift);
+    }
+
+    static size_t DecodeNEON(const char* in, size_t length, unsigned char* out, size_t out_length) {
+        size_t done = 0;
+        size_t written = 0;
+        for (; length - done >= 64 && out_length - written >= 48; done += 64, written += 48) {
+            uint8x16x4_t src = vld4q_u8((const uint8_t*)in + done);
+            uint8x16_t invalid = vdupq_n_u8(0);
+            for (int i = 0; i < 4; ++i)
+                src.val[i] = DecodeLookupNEON(src.val[i], invalid);
+            if (vmaxvq_u8(invalid))
+                break;
+
+            uint8x16x3_t dst;
+            dst.val[0] = vorrq_u8(vshlq_n_u8(src.val[0], 2), vshrq_n_u8(src.val[1], 4));
+            dst.val[1] = vorrq_u8(vshlq_n_u8(src.val[1], 4), vshrq_n_u8(src.val[2], 2));
+            dst.val[2] = vorrq_u8(vshlq_n_u8(src.val[2], 6), src.val[3]);
+            vst3q_u8(out + written, dst);
+        }
+        return done;
+    }
+#endif
 };
@@ -2,6 +2,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/StringUtils.h"
+#include "../Network/DevServerJSON.h"
 #include "../Resource/ResourceCache.h"
 #include "../Scene/Component.h"
 
@@ -38,6 +39,8 @@ namespace Urho3D
 			return "Matrix4";
 		case VAR_INTRECT:
 			return "IntRect";
+		case VAR_RECT:
+			return "Rect";
 		case VAR_INTVECTOR2:
 			return "Vector2";
 		case VAR_VECTOR2:
@@ -62,16 +65,16 @@ namespace Urho3D
 		return "Unknown";
 	}
 
-	String VarToString(Variant var, Context* context)
+	String VarToString(const Variant& var, Context* context)
 	{
 		switch (var.GetType())
 		{
 		case VAR_RESOURCEREF: {
-			ResourceRef ref = var.GetResourceRef();			
+			const ResourceRef& ref = var.GetResourceRef();
 			return context->GetTypeName(ref.type_) + ";" + ref.name_;
 		} break;
 		case VAR_RESOURCEREFLIST: {
-			ResourceRefList list = var.GetResourceRefList();
+			const ResourceRefList& list = var.GetResourceRefList();
 			String ret = context->GetTypeName(list.type_);
 			for (unsigned i = 0; i < list.names_.Size(); ++i)
 			{
@@ -82,7 +85,7 @@ namespace Urho3D
 		} break;
 		case VAR_STRINGVECTOR: {
 			String ret;
-			StringVector list = var.GetStringVector();
+			const StringVector& list = var.GetStringVector();
 			for (unsigned i = 0; i < list.Size(); ++i)
 			{
 				if (i > 0)
@@ -93,7 +96,7 @@ namespace Urho3D
 		} break;
 		case VAR_VARIANTVECTOR: {
 			String ret;
-			VariantVector list = var.GetVariantVector();
+			const VariantVector& list = var.GetVariantVector();
 			for (unsigned i = 0; i < list.Size(); ++i)
 			{
 				if (i > 0)
@@ -108,7 +111,7 @@ namespace Urho3D
 		} break;
 		case VAR_VARIANTMAP: {
 			String ret;
-			VariantMap list = var.GetVariantMap();
+			const VariantMap& list = var.GetVariantMap();
 			auto start = list.Begin();
 			for (auto item = list.Begin(); item != list.End(); ++item)
 			{
@@ -126,6 +129,171 @@ namespace Urho3D
 		}
 	}
 
+	static void WriteFloatsJSON(DevServerJSONWriter& writer, const float* data, unsigned count)
+	{
+		writer.BeginArray();
+		for (unsigned i = 0; i < count; ++i)
+			writer.Value(data[i]);
+		writer.EndArray();
+	}
+
+	static void WriteIntsJSON(DevServerJSONWriter& writer, const int* data, unsigned count)
+	{
+		writer.BeginArray();
+		for (unsigned i = 0; i < count; ++i)
+			writer.Value(data[i]);
+		writer.EndArray();
+	}
+
+	void VariantToJSON(DevServerJSONWriter& writer, const Variant& var, Context* context)
+	{
+		switch (var.GetType())
+		{
+		case VAR_NONE:
+			writer.Null();
+			break;
+		case VAR_BOOL:
+			writer.Value(var.GetBool());
+			break;
+		case VAR_INT:
+			writer.Value(var.GetInt());
+			break;
+		case VAR_INT64:
+			writer.Value(var.GetInt64());
+			break;
+		case VAR_FLOAT:
+			writer.Value(var.GetFloat());
+			break;
+		case VAR_DOUBLE:
+			writer.Value(var.GetDouble());
+			break;
+		case VAR_STRING:
+			writer.Value(var.GetString());
+			break;
+		case VAR_VECTOR2:
+			WriteFloatsJSON(writer, var.GetVector2().Data(), 2);
+			break;
+		case VAR_VECTOR3:
+			WriteFloatsJSON(writer, var.GetVector3().Data(), 3);
+			break;
+		case VAR_VECTOR4:
+			WriteFloatsJSON(writer, var.GetVector4().Data(), 4);
+			break;
+		case VAR_QUATERNION:
+			WriteFloatsJSON(writer, var.GetQuaternion().Data(), 4);
+			break;
+		case VAR_COLOR:
+			WriteFloatsJSON(writer, var.GetColor().Data(), 4);
+			break;
+		case VAR_INTVECTOR2:
+			WriteIntsJSON(writer, var.GetIntVector2().Data(), 2);
+			break;
+		case VAR_INTRECT:
+			WriteIntsJSON(writer, var.GetIntRect().Data(), 4);
+			break;
+		case VAR_RECT:
+			// left, top, right, bottom like an IntRect
+			WriteFloatsJSON(writer, var.GetRect().Data(), 4);
+			break;
+		case VAR_MATRIX3:
+			WriteFloatsJSON(writer, var.GetMatrix3().Data(), 9);
+			break;
+		case VAR_MATRIX3X4:
+			WriteFloatsJSON(writer, var.GetMatrix3x4().Data(), 12);
+			break;
+		case VAR_MATRIX4:
+			WriteFloatsJSON(writer, var.GetMatrix4().Data(), 16);
+			break;
+		case VAR_RESOURCEREF: {
+			const ResourceRef& ref = var.GetResourceRef();
+			writer.BeginObject();
+			writer.Key("type");
+			writer.Value(context->GetTypeName(ref.type_));
+			writer.Key("name");
+			writer.Value(ref.name_);
+			writer.EndObject();
+		} break;
+		case VAR_RESOURCEREFLIST: {
+			const ResourceRefList& list = var.GetResourceRefList();
+			writer.BeginObject();
+			writer.Key("type");
+			writer.Value(context->GetTypeName(list.type_));
+			writer.Key("names");
+			writer.BeginArray();
+			for (const auto& name : list.names_)
+				writer.Value(name);
+			writer.EndArray();
+			writer.EndObject();
+		} break;
+		case VAR_STRINGVECTOR:
+			writer.BeginArray();
+			for (const auto& item : var.GetStringVector())
+				writer.Value(item);
+			writer.EndArray();
+			break;
+		case VAR_VARIANTVECTOR:
+			writer.BeginArray();
+			for (const auto& item : var.GetVariantVector())
+				VariantToJSON(writer, item, context);
+			writer.EndArray();
+			break;
+		case VAR_VARIANTMAP:
+			writer.BeginObject();
+			for (const auto& item : var.GetVariantMap())
+			{
+				writer.Key(String(item.first_));
+				VariantToJSON(writer, item.second_, context);
+			}
+			writer.EndObject();
+			break;
+		default:
+			writer.Value(var.ToString());
+			break;
+		}
+	}
+
+	void SerializableToJSON(DevServerJSONWriter& writer, const Serializable* object, const StringVector& attrs)
+	{
+		writer.BeginObject();
+		writer.Key("type");
+		writer.Value(object->GetTypeName());
+		writer.Key("attributes");
+		writer.BeginObject();
+		if (const Vector<AttributeInfo>* infos = object->GetAttributes())
+		{
+			for (unsigned i = 0; i < infos->Size(); ++i)
+			{
+				const AttributeInfo& attr = (*infos)[i];
+				if (attr.mode_ & AM_NOEDIT)
+					continue;
+				if (!attrs.Empty() && !attrs.Contains(attr.name_))
+					continue;
+				writer.Key(attr.name_);
+				VariantToJSON(writer, object->GetAttribute(i), object->GetContext());
+			}
+		}
+		writer.EndObject();
+		writer.EndObject();
+	}
+
+	bool SetAttributeFromString(Serializable* object, const String& name, const String& value)
+	{
+		if (const Vector<AttributeInfo>* attrs = object->GetAttributes())
+		{
+			for (unsigned i = 0; i < attrs->Size(); ++i)
+			{
+				if ((*attrs)[i].name_.Compare(name) == 0)
+				{
+					Variant var;
+					var.FromString((*attrs)[i].type_, value);
+					object->SetAttribute(i, var);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
 	String SerializableToHTML(const Serializable* object, String url)
 	{
 		String ret;
@@ -158,127 +326,278 @@ namespace Urho3D
 		return ret;
 	}
 
-	void SceneLister::Search(DevServer* server, const StringVector& searchTerms, PODVector<Pair<String, String>>& results)
+	void SceneLister::Search(DevServer* server, const StringVector& searchTerms, Vector<Pair<String, String>>& results)
 	{
-		auto sceneList = server->scenes_;
-		for (auto s : sceneList)
+		static const unsigned MAX_RESULTS_PER_TERM = 100;
+
+		auto snapshot = server->AcquireSnapshot();
+		for (const auto& entry : snapshot->scenes_)
 		{
-			if (s)
+			const String sceneName = entry.name_.Trimmed().Empty() ? String("Unnamed scene") : entry.name_;
+			const String sceneURL = "/Scenes/" + entry.urlName_;
+			for (const auto& rawTerm : searchTerms)
 			{
-				if (searchTerms.Contains(s->GetName()))
-				{
-					results.Push(Pair<String, String>(s->GetName(), "/Scenes"));
+				const bool prefix = rawTerm.EndsWith("*");
+				const String term = prefix ? rawTerm.Substring(0, rawTerm.Length() - 1) : rawTerm;
+				if (term.Empty())
 					continue;
+
+				if (prefix ? entry.name_.StartsWith(term, false) : entry.name_.Contains(term, false))
+					results.Push(MakePair("Scene: " + sceneName, sceneURL));
+
+				if (!entry.index_)
+					continue;
+				Vector<DevSearchMatch> matches;
+				const unsigned total = entry.index_->Find(term, prefix, MAX_RESULTS_PER_TERM, matches);
+				for (const auto& match : matches)
+				{
+					results.Push(MakePair(ToString("%s: %s [%u] (%s)", sceneName.CString(), match.name_.CString(), match.id_, DevSceneIndex::GetFieldName(match.field_)),
+						ToString("%s/Node/%u", sceneURL.CString(), match.id_)));
 				}
+				if (total > matches.Size())
+					results.Push(MakePair(ToString("%s: %u more nodes match '%s'", sceneName.CString(), total - matches.Size(), term.CString()), sceneURL));
 			}
 		}
 	}
 
 	void SceneLister::WriteRawNavigation(DevServer* server, String& data)
 	{
-		if (server->scenes_.Size() > 0)
+		auto snapshot = server->AcquireSnapshot();
+		if (snapshot->scenes_.Size() > 0)
 		{
 			data += "<li class=\"nav-item dropdown\">";
 			data += "<a class=\"nav-link dropdown-toggle\" href=\"#\" id=\"navbarDropdown\" role=\"button\" data-toggle=\"dropdown\" aria-haspopup=\"true\" aria-expanded=\"false\">Scenes</a>";
 			data += "<div class=\"dropdown-menu\" aria-labelledby=\"navbarDropdown\">";
-			auto sceneList = server->scenes_;
-			for (auto scene : sceneList)
+			for (const auto& entry : snapshot->scenes_)
 			{
-				String name = scene->GetName();
+				String name = entry.name_;
 				if (name.Trimmed().Empty())
 					name = "Unnamed scene";
-
-				String safeName = name;
-				safeName.Replace(" ", "_");
-				data += "<a class=\"dropdown-item\" href=\"/Scenes/" + safeName + "\">" + name + "</a>";
+				data += "<a class=\"dropdown-item\" href=\"/Scenes/" + entry.urlName_ + "\">" + name + "</a>";
 			}
 			data += "</div>";
 			data += "</li>";
 		}
 	}
 
+	void SceneContent::RegisterRoutes(DevServerRouter& router)
+	{
+		router.Get(uriBase + "/{scene}", this);
+		router.Get(uriBase + "/{scene}/{kind}/{id}", this);
+		router.Get(uriBase + "/{scene}/Children", this);
+		router.Get(uriBase + "/{scene}/Children/{id}", this);
+		router.Post(uriBase + "/{scene}/{kind}/{id}/{attribute}", this);
+	}
+
 	bool SceneContent::Handles(DevServer*, const Vector<String>& uri)
 	{
 		return uri.Size() > 1 && uri[0].Compare(uriBase, false) == 0;
 	}
 
+	/// Shown in place of scene content when the main thread didn't get to the request in time.
+	static String SceneBusyMessage()
+	{
+		return ToString("<div class=\"well\">The main thread didn't get to this request within %u ms, try again</div>", DevServer::DEFAULT_MAIN_THREAD_TIMEOUT);
+	}
+
 	String SceneContent::EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params)
 	{
-		auto sceneList = server->scenes_;
+		// nodes and components are only read on the main thread, between frames
+		auto body = std::make_shared<String>();
+		const Vector<String> path = uri;
+		if (!server->RunOnMainThread([this, server, path, body]() { *body = BuildBody(server, path); }))
+			*body = SceneBusyMessage();
+
+		return server->FillTemplate("template_object.html", {
+				{ "${TITLE}", "Scene Content" },
+				{ "${BODY}", *body },
+			});
+	}
+
+	String SceneContent::BuildBody(DevServer* server, const Vector<String>& uri)
+	{
 		String body;
-		for (auto scene : sceneList)
+		if (Scene* scene = server->FindScene(uri[1]))
 		{
-			String name = scene->GetName();
-			if (name.Trimmed().Empty())
-				name = "Unnamed scene";
-			String term = uri[1];
-			name.Replace(" ", "_");
-			if (name.Compare(term, false) == 0)
+			const String& name = uri[1];
+			if (uri.Size() > 2)
 			{
-				if (uri.Size() > 2)
+				unsigned val = FromString<unsigned>(uri[3]);
+				if (auto node = scene->GetNode(val))
 				{
-					unsigned val = FromString<unsigned>(uri[3]);
-					if (auto node = scene->GetNode(val))
+					body = SerializableToHTML(node, "/" + String::Joined(uri, "/"));
+					if (node->GetNumComponents() > 0)
 					{
-						body = SerializableToHTML(node, "/" + String::Joined(uri, "/"));
-						if (node->GetNumComponents() > 0)
-						{
-							body += "<h3>Components</h3><ul>";
-							for (unsigned i = 0; i < node->GetNumComponents(); ++i)
-							{
-								auto c = node->GetComponents()[i];
-								String compURI = "/Scenes/" + name + "/Component/" + String(c->GetID());
-								String compHeader = c->GetTypeName() + " [" + String(c->GetID()) + "]";
-								if (c->IsTemporary())
-									compHeader += " (temporary)";
-								String subBody = SerializableToHTML(c, compURI);
-								body += "<button type=\"button\" class=\"close\" aria-label=\"Close\" onclick=\"$.post('" + compURI + "/DELETE', function(data) { location.reload(); });\"><span aria-hidden=\"true\">&times;</span></button>";
-								body += server->Accordian("component_" + String(i), compHeader, subBody);
-							}
-							body += "</ul>";
-						}
-						else
+						body += "<h3>Components</h3><ul>";
+						for (unsigned i = 0; i < node->GetNumComponents(); ++i)
 						{
-							body += "<h3>No Components</h3>";
+							auto c = node->GetComponents()[i];
+							String compURI = "/Scenes/" + name + "/Component/" + String(c->GetID());
+							String compHeader = c->GetTypeName() + " [" + String(c->GetID()) + "]";
+							if (c->IsTemporary())
+								compHeader += " (temporary)";
+							String subBody = SerializableToHTML(c, compURI);
+							body += "<button type=\"button\" class=\"close\" aria-label=\"Close\" onclick=\"$.post('" + compURI + "/DELETE', function(data) { location.reload(); });\"><span aria-hidden=\"true\">&times;</span></button>";
+							body += server->Accordian("component_" + String(i), compHeader, subBody);
 						}
+						body += "</ul>";
+					}
+					else
+					{
+						body += "<h3>No Components</h3>";
 					}
 				}
-				else
-				{
-					body += "<ul>";
-					Print(body, scene, name + "/Node");
-					body += "</ul>";
-				}
-				break;
+			}
+			else
+			{
+				body += "<ul>";
+				Print(body, scene, name + "/Node");
+				body += "</ul>";
 			}
 		}
 
 		if (body.Empty())
 			body = "<div class=\"well\">No contents for scene</div>";
-		
-		return server->FillTemplate("template_object.html", {
-				{ "${TITLE}", "Scene Content" },
-				{ "${BODY}", body },
-			});
+		return body;
+	}
+
+	/// Default and largest number of children in one Children page.
+	static const unsigned CHILDREN_PAGE_SIZE = 200;
+	static const unsigned MAX_CHILDREN_PAGE_SIZE = 5000;
+
+	/// A page of a node's children as {id, total, offset, children: [[id, name, children, components, temporary], ...]}.
+	static String ChildrenToJSON(const Node* node, unsigned offset, unsigned limit)
+	{
+		const Vector<SharedPtr<Node> >& children = node->GetChildren();
+		const unsigned begin = Min(offset, children.Size());
+		const unsigned end = begin + Min(limit, children.Size() - begin);
+
+		DevServerJSONWriter writer((end - begin) * 48 + 64);
+		writer.BeginObject();
+		writer.Key("id");
+		writer.Value(node->GetID());
+		writer.Key("total");
+		writer.Value(children.Size());
+		writer.Key("offset");
+		writer.Value(begin);
+		writer.Key("children");
+		writer.BeginArray();
+		for (unsigned i = begin; i < end; ++i)
+		{
+			const Node* child = children[i];
+			writer.BeginArray();
+			writer.Value(child->GetID());
+			writer.Value(child->GetName());
+			writer.Value(child->GetNumChildren());
+			writer.Value(child->GetNumComponents());
+			writer.Value(child->IsTemporary());
+			writer.EndArray();
+		}
+		writer.EndArray();
+		writer.EndObject();
+		return writer.Detach();
+	}
+
+	/// {"error": message} for the JSON endpoints, sent with a 4xx/5xx status.
+	static String ErrorToJSON(const String& message)
+	{
+		DevServerJSONWriter writer(message.Length() + 16);
+		writer.BeginObject();
+		writer.Key("error");
+		writer.Value(message);
+		writer.EndObject();
+		return writer.Detach();
 	}
 
-	void SceneContent::Print(String& html, const Node* node, String sceneURL, int depth)
+	bool SceneContent::Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response)
 	{
-		html += "<li>";
-		html += "<a href=\"/Scenes/" + sceneURL + "/" + String(node->GetID()) + "\">" + node->GetName() + " [" + String(node->GetID()) + "]";
-		if (node->IsTemporary())
-			html += "(temporary)";
-		html += "</a>";
-
-		auto children = node->GetChildren();
-		if (children.Size() > 0)
+		if (uri.Size() > 2 && uri[2].Compare("Children", false) == 0)
+		{
+			const String sceneName = uri[1];
+			const bool isRoot = uri.Size() < 4;
+			const unsigned id = isRoot ? 0 : FromString<unsigned>(uri[3]);
+			const unsigned offset = ToUInt(GetURIParam(params, "offset", "0"));
+			const unsigned limit = Clamp(ToUInt(GetURIParam(params, "limit", String(CHILDREN_PAGE_SIZE))), 1u, MAX_CHILDREN_PAGE_SIZE);
+
+			// a page costs the main thread about as much as its own length, however big the scene is
+			auto json = std::make_shared<String>();
+			auto status = std::make_shared<int>(200);
+			if (!server->RunOnMainThread([server, sceneName, isRoot, id, offset, limit, json, status]() {
+				Scene* scene = server->FindScene(sceneName);
+				const Node* node = scene && !isRoot ? scene->GetNode(id) : scene;
+				if (node)
+					*json = ChildrenToJSON(node, offset, limit);
+				else
+				{
+					*status = 404;
+					*json = ErrorToJSON("No such node");
+				}
+			}))
+			{
+				*status = 503;
+				*json = ErrorToJSON("The main thread is busy, try again");
+				response.AddHeader("Retry-After", "1");
+			}
+
+			response.SetStatus(*status);
+			response.SetContentType("application/json");
+			response.AddHeader("Cache-Control", "no-cache");
+			response += *json;
+			return true;
+		}
+		if (uri.Size() > 2)
+			return DevServerHandler::Emit(server, uri, params, response);
+
+		if (!server->AcquireSnapshot()->FindScene(uri[1]))
+			return DevServerHandler::Emit(server, uri, params, response);
+
+		// the page only holds the tree's container, its nodes are fetched a page of children at a time as they're expanded
+		if (!params.Contains("all"))
 		{
-			html += "<ul>";
-			for (auto child : children)
-				Print(html, child, sceneURL, depth + 1);
-			html += "</ul>";
+			server->WriteTemplate(response, "template_object.html", { { "${TITLE}", "Scene Content" } }, [&](DevServerResponse& rsp) {
+				rsp += "<p><a href=\"?all=1\">Expand everything</a></p>";
+				rsp += "<div id=\"sceneTree\" data-scene=\"" + EscapeHTML(uri[1]) + "\"></div>";
+				rsp += "<script src=\"/js/scenetree.js\"></script>";
+			});
+			return true;
 		}
-		html += "</li>";
+
+		// the whole tree is written out on the main thread and streamed from here once it's done
+		auto tree = std::make_shared<String>();
+		const String sceneName = uri[1];
+		if (!server->RunOnMainThread([this, server, sceneName, tree]() {
+			if (Scene* scene = server->FindScene(sceneName))
+			{
+				*tree += "<ul>";
+				Print(*tree, scene, sceneName + "/Node");
+				*tree += "</ul>";
+			}
+		}))
+			*tree = SceneBusyMessage();
+
+		server->WriteTemplate(response, "template_object.html", { { "${TITLE}", "Scene Content" } }, [&](DevServerResponse& rsp) {
+			rsp += *tree;
+		});
+		return true;
+	}
+
+	template<typename T>
+	void SceneContent::Print(T& html, const Node* node, const String& sceneURL)
+	{
+		WalkNodes(node, [&](const Node* n, unsigned) {
+			html += "<li>";
+			html += "<a href=\"/Scenes/" + sceneURL + "/" + String(n->GetID()) + "\">" + n->GetName() + " [" + String(n->GetID()) + "]";
+			if (n->IsTemporary())
+				html += "(temporary)";
+			html += "</a>";
+			if (n->GetNumChildren())
+				html += "<ul>";
+			return true;
+		}, [&](const Node* n, unsigned) {
+			if (n->GetNumChildren())
+				html += "</ul>";
+			html += "</li>";
+		});
 	}
 
 	bool SceneContent::HandlesPost(DevServer* server, const Vector<String>& uri)
@@ -288,88 +607,113 @@ namespace Urho3D
 
 	void SceneContent::DoPost(DevServer* server, const Vector<String>& uri, const String& data)
 	{
-		if (uri.Size() < 4)
+		if (uri.Size() < 5)
 			return;
 
-		String sceneName = uri[1];
-		String nodeName = uri[2];
-		String nodeIDStr = uri[3];
+		const String sceneName = uri[1];
+		const String kind = uri[2];
+		const unsigned id = FromString<unsigned>(uri[3]);
 		String attrName = uri[4];
 		attrName.Replace('_', ' ');
-		unsigned nodeID = FromString<unsigned>(nodeIDStr);
 
-		auto sceneList = server->scenes_;
-		for (auto scene : sceneList)
-		{
-			String name = scene->GetName();
-			if (name.Trimmed().Empty())
-				name = "Unnamed scene";
-			String term = uri[1];
-			name.Replace(" ", "_");
-			if (name.Compare(term, false) == 0)
+		// everything is looked up when the edit runs, on the main thread, in case the object went away in the meantime
+		server->AddDeferredCommand([server, sceneName, kind, id, attrName, data]() {
+			Scene* scene = server->FindScene(sceneName);
+			if (!scene)
+				return;
+
+			Serializable* object = nullptr;
+			if (kind == "Node")
+				object = scene->GetNode(id);
+			else if (kind == "Component")
+				object = scene->GetComponent(id);
+			if (!object)
+				return;
+
+			if (attrName.Compare("delete", false) == 0)
 			{
-				if (nodeName == "Node")
-				{
-					Variant var;
-					if (auto n = scene->GetNode(nodeID))
-					{
-						if (attrName.Compare("delete", false) == 0)
-						{
-							SharedPtr<Node> sharedNode(n);
-							server->AddDeferredCommand([=]() {
-								sharedNode->Remove();
-							});
-						}
-						else
-						{
-							auto attrs = n->GetAttributes();
-							for (auto attr : *attrs)
-							{
-								if (attr.name_.Compare(attrName) == 0)
-								{
-									var.FromString(attr.type_, data);
-									SharedPtr<Node> node(n);
-									server->AddDeferredCommand([=]() {
-										node->SetAttribute(attrName, var);
-									});
-									break;
-								}
-							}
-						}
-					}
-				}
-				else if (nodeName == "Component")
+				if (kind == "Node")
+					static_cast<Node*>(object)->Remove();
+				else
+					static_cast<Component*>(object)->Remove();
+			}
+			else
+				SetAttributeFromString(object, attrName, data);
+		});
+	}
+
+	void SceneAPI::RegisterRoutes(DevServerRouter& router)
+	{
+		router.Get("api/Scenes/{scene}/{kind}/{id}", this);
+	}
+
+	/// A scene from an API path, by slug or failing that by id. Main thread.
+	static Scene* FindAPIScene(DevServer* server, const String& key)
+	{
+		if (Scene* scene = server->FindScene(key))
+			return scene;
+		return server->GetScene(ToUInt(key));
+	}
+
+	bool SceneAPI::Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response)
+	{
+		const String sceneKey = GetURIParam(params, "scene");
+		const String kind = GetURIParam(params, "kind");
+		const unsigned id = ToUInt(GetURIParam(params, "id"));
+		const bool isNode = kind.Compare("Node", false) == 0;
+		if (!isNode && kind.Compare("Component", false) != 0)
+			return false;
+
+		const String attrList = GetURIParam(params, "attrs");
+		const StringVector attrs = attrList.Split(',');
+
+		// the attributes are written straight into the writer's buffer on the main thread, which is then moved out whole
+		auto json = std::make_shared<String>();
+		auto status = std::make_shared<int>(200);
+		if (!server->RunOnMainThread([server, sceneKey, isNode, id, attrs, json, status]() {
+			Scene* scene = FindAPIScene(server, sceneKey);
+			const Serializable* object = nullptr;
+			if (scene)
+				object = isNode ? static_cast<Serializable*>(scene->GetNode(id)) : static_cast<Serializable*>(scene->GetComponent(id));
+			if (!object)
+			{
+				*status = 404;
+				*json = ErrorToJSON(scene ? (isNode ? "No such node" : "No such component") : "No such scene");
+				return;
+			}
+
+			DevServerJSONWriter writer(1024);
+			writer.BeginObject();
+			writer.Key("id");
+			writer.Value(id);
+			writer.Key("object");
+			SerializableToJSON(writer, object, attrs);
+			if (isNode)
+			{
+				writer.Key("components");
+				writer.BeginArray();
+				for (const auto& component : static_cast<const Node*>(object)->GetComponents())
 				{
-					if (auto c = scene->GetComponent(nodeID))
-					{
-						if (attrName.Compare("delete", false) == 0)
-						{
-							SharedPtr<Component> comp(c);
-							server->AddDeferredCommand([=]() {
-								comp->Remove();
-							});
-						}
-						else
-						{
-							auto attrs = c->GetAttributes();
-							for (auto attr : *attrs)
-							{
-								if (attr.name_.Compare(attrName) == 0)
-								{
-									Variant var;
-									var.FromString(attr.type_, data);
-									SharedPtr<Component> comp(c);
-									server->AddDeferredCommand([=]() {
-										comp->SetAttribute(attrName, var);
-									});
-									break;
-								}
-							}
-						}
-					}
+					writer.BeginArray();
+					writer.Value(component->GetID());
+					writer.Value(component->GetTypeName());
+					writer.EndArray();
 				}
-				break;
+				writer.EndArray();
 			}
+			writer.EndObject();
+			*json = writer.Detach();
+		}))
+		{
+			*status = 503;
+			*json = ErrorToJSON("The main thread is busy, try again");
+			response.AddHeader("Retry-After", "1");
 		}
+
+		response.SetStatus(*status);
+		response.SetContentType("application/json");
+		response.AddHeader("Cache-Control", "no-cache");
+		response += *json;
+		return true;
 	}
-}
\ No newline at end of file
+}
@@ -6,6 +6,56 @@
 
 namespace Urho3D
 {
+	class DevServerJSONWriter;
+
+	/// Formats an attribute value the way the inspector displays and edits it.
+	URHO3D_API String VarToString(const Variant& var, Context* context);
+	/// Writes an attribute value as JSON: numbers, strings and bools as themselves; vectors, quaternions (w, x, y, z), colors, rects and matrices
+	/// as arrays of numbers; resource refs as {type, name} or {type, names}; variant vectors and maps as arrays and objects (keyed by hash, as VarToString shows them).
+	/// Anything else is written as the string Variant::ToString gives.
+	URHO3D_API void VariantToJSON(DevServerJSONWriter& writer, const Variant& var, Context* context);
+	/// Writes {type, attributes: {name: value, ...}} for an object's editable attributes, only the ones named in attrs when it isn't empty.
+	URHO3D_API void SerializableToJSON(DevServerJSONWriter& writer, const Serializable* object, const StringVector& attrs = StringVector());
+	/// Parses value as the named attribute's type and sets it, returns false if the object has no such attribute.
+	URHO3D_API bool SetAttributeFromString(Serializable* object, const String& name, const String& value);
+
+	/// Visits root and its descendants depth first without recursing or copying child lists.
+	/// enter(node, depth) is called on the way down and returns whether to visit the node's children,
+	/// leave(node, depth) is called once the node's subtree is done (straight after enter when it's skipped).
+	template<typename Enter, typename Leave>
+	void WalkNodes(const Node* root, Enter enter, Leave leave)
+	{
+		if (!root)
+			return;
+		if (!enter(root, 0u))
+		{
+			leave(root, 0u);
+			return;
+		}
+
+		// each entry is a node and the index of the next child to visit
+		PODVector<Pair<const Node*, unsigned> > stack;
+		stack.Push(MakePair(root, 0u));
+		while (!stack.Empty())
+		{
+			const unsigned depth = stack.Size() - 1;
+			const Node* node = stack.Back().first_;
+			const Vector<SharedPtr<Node> >& children = node->GetChildren();
+			if (stack.Back().second_ < children.Size())
+			{
+				const Node* child = children[stack.Back().second_++];
+				if (enter(child, depth + 1))
+					stack.Push(MakePair(child, 0u));
+				else
+					leave(child, depth + 1);
+			}
+			else
+			{
+				stack.Pop();
+				leave(node, depth);
+			}
+		}
+	}
 
 	/// This doesn't actually emit HTML aside from through WriteRawNavigation for creating the drop-down menu of scenes.
 	struct SceneLister : DevServerHandler {
@@ -14,19 +64,37 @@ namespace Urho3D
 		virtual bool Handles(DevServer*, const Vector<String>& uri) override { return false; }
 		virtual String EmitHTML(DevServer*, const Vector<String>& uri, const VariantMap& params) override { return String(); }
 
-		virtual void Search(DevServer* server, const StringVector& searchTerms, PODVector<Pair<String, String>>& results) override;
+		virtual void Search(DevServer* server, const StringVector& searchTerms, Vector<Pair<String, String>>& results) override;
 		virtual void WriteRawNavigation(DevServer* server, String& data) override;
 	};
 
 	struct SceneContent : DevServerHandler {
 		const String uriBase = "Scenes";
 
+		virtual void RegisterRoutes(DevServerRouter& router) override;
 		virtual bool Handles(DevServer*, const Vector<String>& uri) override;
 		virtual String EmitHTML(DevServer*, const Vector<String>& uri, const VariantMap& params) override;
+		/// Sends the lazily expanded scene tree (the whole tree with ?all) and Scenes/<scene>/Children/<id> JSON,
+		/// node and component pages go through EmitHTML.
+		virtual bool Emit(DevServer*, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response) override;
 
 		virtual bool HandlesPost(DevServer*, const Vector<String>& uri) override;
 		virtual void DoPost(DevServer*, const Vector<String>& uri, const String& data) override;
 
-		void Print(String& html, const Node* node, String sceneURL, int depth = 0);
+		/// Builds a node or component page, or the whole tree. Main thread.
+		String BuildBody(DevServer* server, const Vector<String>& uri);
+		/// Writes the node tree as nested lists, T is a String or DevServerResponse. Main thread.
+		template<typename T>
+		void Print(T& html, const Node* node, const String& sceneURL);
+	};
+
+	/// Machine-readable attributes for tooling: api/Scenes/<scene>/Node/<id> and api/Scenes/<scene>/Component/<id>,
+	/// where <scene> is a scene's slug or id. ?attrs=Position,Rotation limits the attributes written.
+	struct SceneAPI : DevServerHandler {
+		virtual void RegisterRoutes(DevServerRouter& router) override;
+		virtual bool Handles(DevServer*, const Vector<String>& uri) override { return false; }
+		virtual String EmitHTML(DevServer*, const Vector<String>& uri, const VariantMap& params) override { return String(); }
+		/// Reads the object on the main thread. A missing scene or object is a 404 and a busy main thread a 503, both with an {"error"} body.
+		virtual bool Emit(DevServer*, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response) override;
 	};
 }
@@ -2,19 +2,25 @@
 
 #include "../Core/CoreEvents.h"
 #include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Core/StringUtils.h"
+#include "../Core/Timer.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/IOEvents.h"
-#include "../Math/Base64.h"
 
 #include "../Resource/XMLFile.h"
 #include "../Resource/ResourceCache.h"
+#include "../Resource/ResourceEvents.h"
 
 #include "../Resource/Image.h"
 #include "../Graphics/Texture2D.h"
 
 #include "../Network/DevInspector.h"
+#include "../Network/DevServerCompression.h"
+#include "../Network/DevServerImage.h"
+#include "../Network/DevServerJSON.h"
 
 #ifdef URHO3D_ANGELSCRIPT
 	#include "../AngelScript/Script.h"
@@ -23,33 +29,229 @@
 #include <STB/stb_image.h>
 #include <STB/stb_image_write.h>
 
-extern unsigned char *stbi_write_png_to_mem(unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len);
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 
 namespace Urho3D
 {
+	/// How often a cached template checks its file's modification time.
+	static const unsigned TEMPLATE_CHECK_INTERVAL_MS = 500;
+	/// stb deflate quality for pages compressed per request, favours speed.
+	static const int DYNAMIC_COMPRESSION_QUALITY = 5;
+	/// stb deflate quality for /web files, compressed once so favour size.
+	static const int STATIC_COMPRESSION_QUALITY = 12;
+
+	/// URL-decodes a query string component ('+' is a space).
+	static String URLDecode(const String& src)
+	{
+		PODVector<char> decoded(src.Length() + 1);
+		const int length = mg_url_decode(src.CString(), (int)src.Length(), &decoded[0], (int)decoded.Size(), 1);
+		return length >= 0 ? String(&decoded[0], (unsigned)length) : src;
+	}
+
+	/// Splits a query string into params as Strings keyed by parameter name.
+	static void ParseQueryString(const String& query, VariantMap& params)
+	{
+		if (query.Empty())
+			return;
+
+		Vector<String> pairs = query.Split('&');
+		for (const auto& pair : pairs)
+		{
+			const unsigned eq = pair.Find('=');
+			const String key = URLDecode(eq == String::NPOS ? pair : pair.Substring(0, eq));
+			if (!key.Empty())
+				params[key] = eq == String::NPOS ? String() : URLDecode(pair.Substring(eq + 1));
+		}
+	}
+
+	/// Built-in Server-Sent Events channels.
+	static const String STREAM_LOG("Log");
+	static const String STREAM_PAGES("Pages");
+	/// Idle time after which a stream sends a comment, keeps proxies from closing it and notices dead clients.
+	static const unsigned STREAM_KEEPALIVE_MS = 15000;
+
+	/// Mime type for a compressible /web file, empty for anything that isn't worth compressing.
+	static String GetWebMimeType(const String& fileName)
+	{
+		const String ext = GetExtension(fileName);
+		if (ext == ".css")
+			return "text/css";
+		if (ext == ".js")
+			return "application/javascript";
+		if (ext == ".html" || ext == ".htm")
+			return "text/html";
+		if (ext == ".json" || ext == ".map")
+			return "application/json";
+		if (ext == ".svg")
+			return "image/svg+xml";
+		if (ext == ".txt")
+			return "text/plain";
+		return String();
+	}
+
+	/// Percent-encodes a resource path for use in a URL, keeping its slashes unless it's meant to be a single segment.
+	static String URLEncodePath(const String& src, bool keepSlashes = true)
+	{
+		static const char HEX[] = "0123456789ABCDEF";
+		String ret;
+		ret.Reserve(src.Length());
+		for (unsigned i = 0; i < src.Length(); ++i)
+		{
+			const unsigned char c = (unsigned char)src[i];
+			if (isalnum(c) || (c == '/' && keepSlashes) || c == '.' || c == '_' || c == '-' || c == '~')
+				ret += (char)c;
+			else
+			{
+				ret += '%';
+				ret += HEX[c >> 4];
+				ret += HEX[c & 15];
+			}
+		}
+		return ret;
+	}
+
+	/// Reads ?fmt= and ?level= for an image request.
+	static void GetImageParams(const VariantMap& params, DevImageFormat& format, int& level)
+	{
+		format = ParseImageFormat(GetURIParam(params, "fmt"));
+		level = Clamp(ToInt(GetURIParam(params, "level", String(DEFAULT_IMAGE_LEVEL))), 0, 9);
+	}
+
+	/// ETag suffix telling the encodings of one image apart.
+	static String GetImageETagSuffix(const VariantMap& params)
+	{
+		DevImageFormat format;
+		int level;
+		GetImageParams(params, format, level);
+		return format == DIF_PNG ? ToString("-png%d", level) : String("-") + GetImageFormatName(format);
+	}
+
+	/// Writes an encoded image as the response, raw pixels get their layout in X-Image-* headers.
+	static void WriteImageResponse(DevServerResponse& response, DevImageFormat format, unsigned width, unsigned height, unsigned components, const PODVector<unsigned char>& encoded)
+	{
+		response.SetContentType(GetImageMimeType(format));
+		if (format == DIF_RAW)
+		{
+			response.AddHeader("X-Image-Width", String(width));
+			response.AddHeader("X-Image-Height", String(height));
+			response.AddHeader("X-Image-Components", String(components));
+		}
+		response.SetContentLength(encoded.Size());
+		response.Write(encoded.Buffer(), encoded.Size());
+	}
+
+	/// Encodes an image in the format asked for by ?fmt= and ?level= and writes it as the response.
+	/// Runs on the civetweb worker serving the request, so a slow encode never holds up the frame.
+	static bool SendImage(DevServerResponse& response, const Image* image, const VariantMap& params)
+	{
+		DevImageFormat format;
+		int level;
+		GetImageParams(params, format, level);
+
+		DevImagePreview preview;
+		PODVector<unsigned char> encoded;
+		if (!GetImagePreview(image, preview) || !EncodeImage(preview.pixels_, preview.width_, preview.height_, preview.components_, format, level, encoded))
+			return false;
+		WriteImageResponse(response, format, preview.width_, preview.height_, preview.components_, encoded);
+		return true;
+	}
+
+	/// Largest thumbnail ?w= may ask for.
+	static const unsigned MAX_THUMBNAIL_SIZE = 1024;
+	/// Thumbnails held before the cache is flushed and starts over.
+	static const unsigned MAX_CACHED_THUMBNAILS = 1024;
+	/// Thumbnail size used by the resource list grid.
+	static const unsigned GRID_THUMBNAIL_SIZE = 128;
+
+	/// Returns the ?w= thumbnail size asked for, 0 for the full image.
+	static unsigned GetThumbnailSize(const VariantMap& params)
+	{
+		const unsigned size = ToUInt(GetURIParam(params, "w"));
+		return size ? Min(size, MAX_THUMBNAIL_SIZE) : 0;
+	}
+
+	/// Copies the first slice of an image as 8-bit pixels, the snapshot a publish history keeps.
+	static SharedPtr<Image> CopyImage(const Image* image)
+	{
+		DevImagePreview preview;
+		if (!GetImagePreview(image, preview))
+			return SharedPtr<Image>();
+		SharedPtr<Image> copy(new Image(image->GetContext()));
+		if (!copy->SetSize(preview.width_, preview.height_, preview.components_))
+			return SharedPtr<Image>();
+		copy->SetData(preview.pixels_);
+		copy->SetName(image->GetName());
+		return copy;
+	}
+
+	/// Takes a reference to an image behind a std::shared_ptr, whose atomic count lets request threads borrow it.
+	/// The reference is released wherever the last std::shared_ptr goes, keep one on the main thread so that's always there.
+	static std::shared_ptr<Image> HoldImage(Image* image)
+	{
+		image->AddRef();
+		return std::shared_ptr<Image>(image, [](Image* held) { held->ReleaseRef(); });
+	}
+
+	/// Identifies the current state of a resource, identity catches replacement, memory use catches resizes, the generation catches in-place reloads.
+	static String GetResourceTag(DevServer* server, Resource* res)
+	{
+		return ToString("r%x-%x-%u", (unsigned)(size_t)res, res->GetMemoryUse(), server->GetResourceGeneration());
+	}
 
 	struct ResourceCacheProvider : public DevServerDataHandler {
 		const String uriBase = "ResourceCache";
 
+		virtual void RegisterRoutes(DevServerRouter& router) override {
+			router.Get(uriBase + "/{*resource}", this);
+		}
 		virtual bool Handles(DevServer*, const Vector<String>& uri) override {
 			return uri.Size() > 0 && uri[0].Compare(uriBase, false) == 0;
 		}
-		virtual bool EmitData(DevServer* server, const Vector<String>& uri, String& mimeType, VectorBuffer& buffer) override {
-			String trimmed = uri[1];
+		virtual String GetETag(DevServer* server, const Vector<String>& uri, const VariantMap& params) override {
+			auto cache = server->GetContext()->GetSubsystem<ResourceCache>();
+			if (!cache)
+				return String();
+
+			const String name = GetURIParam(params, "resource");
+			Resource* res = cache->GetExistingResource<Image>(name);
+			if (!res)
+				res = cache->GetExistingResource<XMLFile>(name);
+			if (!res)
+				return String();
+
+			String tag = GetResourceTag(server, res);
+			if (res->GetType() == Image::GetTypeStatic())
+			{
+				tag += GetImageETagSuffix(params);
+				if (const unsigned size = GetThumbnailSize(params))
+					tag += ToString("-w%u", size);
+			}
+			return tag;
+		}
+		virtual bool Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response) override {
+			auto cache = server->GetContext()->GetSubsystem<ResourceCache>();
+			if (!cache)
+				return false;
+			const String name = GetURIParam(params, "resource");
+			if (auto img = cache->GetExistingResource<Image>(name))
+			{
+				const unsigned size = GetThumbnailSize(params);
+				if (size && ((unsigned)img->GetWidth() > size || (unsigned)img->GetHeight() > size))
+					return SendThumbnail(server, response, name, img, size, params);
+				return SendImage(response, img, params);
+			}
+			return DevServerDataHandler::Emit(server, uri, params, response);
+		}
+		virtual bool EmitData(DevServer* server, const Vector<String>& uri, const VariantMap& params, String& mimeType, VectorBuffer& buffer) override {
+			String trimmed = GetURIParam(params, "resource");
 			auto ctx = server->GetContext();
 			if (auto cache = ctx->GetSubsystem<ResourceCache>())
 			{
-				if (auto img = cache->GetExistingResource<Image>(trimmed))
-				{
-					int len;
-					unsigned char* png = stbi_write_png_to_mem(img->GetData(), 0, img->GetWidth(), img->GetHeight(), img->GetComponents(), &len);
-					bool success = buffer.Write(png, (unsigned)len) == (unsigned)len;
-					free(png);
-
-					mimeType = "image/png";
-					return true;
-				}
-				else if (auto xml = cache->GetExistingResource<XMLFile>(trimmed))
+				// images are sent by Emit
+				if (auto xml = cache->GetExistingResource<XMLFile>(trimmed))
 				{
 					xml->Save(buffer);
 					mimeType = "application/xml";
@@ -61,10 +263,70 @@ namespace Urho3D
 		}
 
 		virtual void WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI) override { }
+
+		/// A downsampled, encoded image.
+		struct Thumbnail {
+			/// The resource's ETag when it was made, a mismatch means the image has since changed.
+			String resourceTag_;
+			unsigned width_;
+			unsigned height_;
+			unsigned components_;
+			std::shared_ptr<const PODVector<unsigned char>> data_;
+		};
+
+		/// Sends a thumbnail no larger than size, downsampling and encoding it only when the cached one is stale.
+		bool SendThumbnail(DevServer* server, DevServerResponse& response, const String& name, Image* img, unsigned size, const VariantMap& params)
+		{
+			DevImageFormat format;
+			int level;
+			GetImageParams(params, format, level);
+			const String resourceTag = GetResourceTag(server, img);
+			const String key = ToString("%s|%u|%s|%d", name.CString(), size, GetImageFormatName(format), format == DIF_PNG ? level : 0);
+
+			Thumbnail thumbnail;
+			{
+				MutexLock lock(thumbnailsMutex_);
+				auto found = thumbnails_.Find(key);
+				if (found != thumbnails_.End() && found->second_.resourceTag_ == resourceTag)
+					thumbnail = found->second_;
+			}
+
+			if (!thumbnail.data_)
+			{
+				// made outside the lock so a big image doesn't hold up other thumbnails of the grid
+				DevImagePreview preview;
+				if (!GetImagePreview(img, preview))
+					return false;
+				PODVector<unsigned char> pixels;
+				if (!DownsampleImage(preview.pixels_, preview.width_, preview.height_, preview.components_, size, pixels, thumbnail.width_, thumbnail.height_))
+					return SendImage(response, img, params);
+				auto encoded = std::make_shared<PODVector<unsigned char>>();
+				if (!EncodeImage(pixels.Buffer(), thumbnail.width_, thumbnail.height_, preview.components_, format, level, *encoded))
+					return false;
+				thumbnail.components_ = preview.components_;
+				thumbnail.resourceTag_ = resourceTag;
+				thumbnail.data_ = encoded;
+
+				MutexLock lock(thumbnailsMutex_);
+				if (thumbnails_.Size() >= MAX_CACHED_THUMBNAILS)
+					thumbnails_.Clear();
+				thumbnails_[key] = thumbnail;
+			}
+
+			WriteImageResponse(response, format, thumbnail.width_, thumbnail.height_, thumbnail.components_, *thumbnail.data_);
+			return true;
+		}
+
+		/// Thumbnails keyed by resource name, size and encoding, shared by the request threads.
+		HashMap<String, Thumbnail> thumbnails_;
+		Mutex thumbnailsMutex_;
 	};
 
 	struct ResourceListProvider : public DevServerHandler {
 		const String uriBase = "Resources";
+		virtual void RegisterRoutes(DevServerRouter& router) override {
+			router.Get(uriBase, this);
+		}
 		virtual bool Handles(DevServer*, const Vector<String>& uri) override { 
 			return uri.Size() > 0 && uri[0].Compare(uriBase, false) == 0; 
 		}
@@ -100,12 +362,29 @@ namespace Urho3D
 					ret += "<div class=\"panel-heading\"><h4 class=\"panel-title\"><a data-toggle=\"collapse\" href=\"#" + resTypeName + "\">" + resTypeName + " - " + memTotalString + "</a></h4></div>";
 					const auto resources = grp.second_.resources_;
 					ret += "<div id=\"" + resTypeName + "\" class=\"panel-collapse collapse\">";
-					ret += "<ul class=\"list-group\">";
-					for (auto res : resources)
+					if (grp.first_ == Image::GetTypeStatic())
+					{
+						// lazy loading keeps a phone from fetching the whole grid up front
+						ret += "<div class=\"panel-body\"><div class=\"row\">";
+						for (auto res : resources)
+						{
+							const String name = EscapeHTML(res.second_->GetName());
+							const String url = "/ResourceCache/" + URLEncodePath(res.second_->GetName());
+							ret += "<div class=\"col-xs-6 col-sm-3 col-md-2\"><a class=\"thumbnail\" href=\"" + url + "\" title=\"" + name + "\">";
+							ret += ToString("<img loading=\"lazy\" src=\"%s?w=%u\" alt=\"%s\" style=\"max-height:%upx\" />", url.CString(), GRID_THUMBNAIL_SIZE, name.CString(), GRID_THUMBNAIL_SIZE);
+							ret += "<div class=\"caption\"><small>" + name + " - " + GetFileSizeString(res.second_->GetMemoryUse()) + "</small></div></a></div>";
+						}
+						ret += "</div></div>";
+					}
+					else
 					{
-						ret += "<li class=\"list-group-item\"><b>" + res.second_->GetName() + "</b> - " + GetFileSizeString(res.second_->GetMemoryUse()) + "</li>";
+						ret += "<ul class=\"list-group\">";
+						for (auto res : resources)
+						{
+							ret += "<li class=\"list-group-item\"><b>" + res.second_->GetName() + "</b> - " + GetFileSizeString(res.second_->GetMemoryUse()) + "</li>";
+						}
+						ret += "</ul>";
 					}
-					ret += "</ul>";
 					ret += "</div>";
 				}
 				ret += "</div>";
@@ -123,22 +402,67 @@ namespace Urho3D
 		}
 	};
 
+	bool DevServerHandler::Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response)
+	{
+		response.SetContentType("text/html");
+		response += EmitHTML(server, uri, params);
+		return true;
+	}
+
+	bool DevServerDataHandler::Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response)
+	{
+		VectorBuffer buffer;
+		String mimeType;
+		if (!EmitData(server, uri, params, mimeType, buffer))
+			return false;
+
+		response.SetContentType(mimeType);
+		response.SetContentLength(buffer.GetSize());
+		response.Write(buffer.GetData(), buffer.GetSize());
+		return true;
+	}
+
 	DevServer::DevServer(Context* ctx) : 
 		Object(ctx),
-		netContext_(nullptr)
+		netContext_(nullptr),
+		publishCounter_(0),
+		resourceGeneration_(0),
+		historyFrames_(0),
+		historyBudget_(DEFAULT_HISTORY_BUDGET),
+		historyBytes_(0),
+		historyTick_(0),
+		watchHub_(new DevServerWatchHub(this)),
+		nextSceneId_(1),
+		navGeneration_(1),
+		navCacheGeneration_(0),
+		compressionEnabled_(true),
+		compressionThreshold_(1024),
+		commandBudget_(DEFAULT_COMMAND_BUDGET),
+		snapshotDirty_(true),
+		navigationDirty_(true)
 	{
+		// requests can arrive as soon as the server starts, there's always a snapshot for them
+		UpdateSnapshot();
 		static int defaultPort = 80;
 		RestartServer(defaultPort);
-		handlers_.Push(new SceneLister());
-		handlers_.Push(new SceneContent());
-		handlers_.Push(new LogHandler());
-		handlers_.Push(new ResourceListProvider());
-		handlers_.Push(new ResourceCacheProvider());
-		handlers_.Push(new SimpleHandler());
-		handlers_.Push(new CommandHandler());
+		AddHandler(new SceneLister());
+		AddHandler(new SceneContent());
+		AddHandler(new SceneAPI());
+		AddHandler(new LogHandler());
+		AddHandler(new ResourceListProvider());
+		AddHandler(new ResourceCacheProvider());
+		AddHandler(new SimpleHandler());
+		AddHandler(new CommandHandler());
+		AddHandler(new CompressionHandler());
+		AddHandler(new StatsHandler());
+		AddHandler(new SearchHandler());
+		AddHandler(new MetricsHandler());
+		AddHandler(new ProfilerHandler());
+		AddHandler(new StreamHandler());
 
 		SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(DevServer, OnNewFrame));
 		SubscribeToEvent(E_LOGMESSAGE, URHO3D_HANDLER(DevServer, OnLog));
+		SubscribeToEvent(E_RELOADFINISHED, URHO3D_HANDLER(DevServer, OnResourceReloaded));
 
 #ifdef URHO3D_ANGELSCRIPT
 		RegisterCommand("Dump Script Header", [](Context* ctx) {
@@ -166,6 +490,9 @@ namespace Urho3D
 
 	DevServer::~DevServer()
 	{
+		// open streams and sockets hold workers that mg_stop would wait on forever
+		streamHub_.Shutdown();
+		watchHub_->Shutdown();
 		if (netContext_)
 		{
 			mg_stop(netContext_);
@@ -187,9 +514,12 @@ namespace Urho3D
 	{
 		if (netContext_)
 		{
+			streamHub_.Shutdown();
+			watchHub_->Shutdown();
 			mg_stop(netContext_);
 			netContext_ = nullptr;
 		}
+		streamHub_.Resume();
 			
 		memset(&callbacks_, 0, sizeof(mg_callbacks));
 		callbacks_.begin_request = BeginRequest;
@@ -213,7 +543,147 @@ namespace Urho3D
 		else
 		{
 			URHO3D_LOGDEBUGF("Started debug server on port: %u", port);
+			watchHub_->Install(netContext_);
+		}
+
+		PrecompressWebFiles();
+	}
+
+	std::shared_ptr<DevServer::StaticAsset> DevServer::CompressWebFile(Context* ctx, const String& fileName)
+	{
+		const String mimeType = GetWebMimeType(fileName);
+		if (mimeType.Empty())
+			return nullptr;
+
+		File file(ctx, fileName);
+		if (!file.IsOpen() || file.GetSize() == 0)
+			return nullptr;
+		PODVector<unsigned char> data(file.GetSize());
+		if (file.Read(&data[0], data.Size()) != data.Size())
+			return nullptr;
+
+		auto asset = std::make_shared<StaticAsset>();
+		if (!DeflateRaw(&data[0], data.Size(), STATIC_COMPRESSION_QUALITY, asset->deflate_, asset->adler_) || asset->deflate_.Size() >= data.Size())
+			return nullptr;
+		asset->fileName_ = fileName;
+		asset->mimeType_ = mimeType;
+		asset->rawSize_ = data.Size();
+		asset->crc_ = CRC32(&data[0], data.Size());
+		asset->modifiedTime_ = ctx->GetSubsystem<FileSystem>()->GetLastModifiedTime(fileName);
+		return asset;
+	}
+
+	void DevServer::PrecompressWebFiles()
+	{
+		auto fileSystem = GetContext()->GetSubsystem<FileSystem>();
+		const String webDir = fileSystem->GetProgramDir() + "web/";
+		Vector<String> files;
+		fileSystem->ScanDir(files, webDir, "*", SCAN_FILES, true);
+
+		HiresTimer timer;
+		unsigned long long rawTotal = 0;
+		unsigned long long compressedTotal = 0;
+		HashMap<String, std::shared_ptr<const StaticAsset>> assets;
+		for (const auto& file : files)
+		{
+			if (auto asset = CompressWebFile(GetContext(), webDir + file))
+			{
+				rawTotal += asset->rawSize_;
+				compressedTotal += asset->deflate_.Size();
+				assets["/" + file] = asset;
+			}
+		}
+
+		{
+			MutexLock lock(staticMutex_);
+			staticAssets_ = assets;
+		}
+		URHO3D_LOGDEBUGF("DevServer precompressed %u web files, %s to %s in %.1f ms", assets.Size(), GetFileSizeString(rawTotal).CString(),
+			GetFileSizeString(compressedTotal).CString(), timer.GetUSec(false) / 1000.0f);
+	}
+
+	bool DevServer::SendStaticAsset(struct mg_connection* conn, const String& uri)
+	{
+		if (!compressionEnabled_)
+			return false;
+		HiresTimer timer;
+		const DevServerEncoding encoding = NegotiateEncoding(mg_get_header(conn, "Accept-Encoding"));
+		if (encoding == DSE_IDENTITY)
+			return false;
+
+		std::shared_ptr<const StaticAsset> asset;
+		{
+			MutexLock lock(staticMutex_);
+			auto found = staticAssets_.Find(uri);
+			if (found == staticAssets_.End())
+				return false;
+			asset = found->second_;
+		}
+
+		// keep live-editing of the web files working
+		if (GetContext()->GetSubsystem<FileSystem>()->GetLastModifiedTime(asset->fileName_) != asset->modifiedTime_)
+		{
+			const String fileName = asset->fileName_;
+			asset = CompressWebFile(GetContext(), fileName);
+			MutexLock lock(staticMutex_);
+			if (!asset)
+			{
+				staticAssets_.Erase(uri);
+				return false;
+			}
+			staticAssets_[uri] = asset;
+		}
+
+		DevRequestTiming timing;
+		const String etag = ToString("W/\"w%x-%x\"", asset->modifiedTime_, asset->rawSize_);
+		if (MatchesETag(conn, etag))
+		{
+			SendNotModified(conn, etag);
+			timing.match_ = timing.total_ = (unsigned)timer.GetUSec(false);
+			timing.notModified_ = true;
+			stats_.RecordRequest(uri, timing);
+			return true;
 		}
+		timing.match_ = (unsigned)timer.GetUSec(false);
+
+		PODVector<unsigned char> header, trailer;
+		GetEncodingFrame(encoding, asset->rawSize_, asset->crc_, asset->adler_, header, trailer);
+
+		DevServerResponse response(conn);
+		response.AddHeader("ETag", etag);
+		response.SetContentType(asset->mimeType_);
+		response.SetContentLength(header.Size() + asset->deflate_.Size() + trailer.Size());
+		response.AddHeader("Content-Encoding", GetEncodingName(encoding));
+		response.AddHeader("Vary", "Accept-Encoding");
+		response.Write(&header[0], header.Size());
+		if (!asset->deflate_.Empty())
+			response.Write(&asset->deflate_[0], asset->deflate_.Size());
+		response.Write(&trailer[0], trailer.Size());
+		response.Finish();
+
+		RecordCompression(uri, asset->rawSize_, response.GetSentSize(), 0);
+		timing.total_ = (unsigned)timer.GetUSec(false);
+		timing.write_ = (unsigned)response.GetWriteTime();
+		timing.emit_ = timing.total_ - Min(timing.total_, timing.match_ + timing.write_);
+		timing.bytes_ = response.GetSentSize();
+		stats_.RecordRequest(uri, timing);
+		return true;
+	}
+
+	void DevServer::RecordCompression(const String& endpoint, unsigned rawBytes, unsigned sentBytes, long long usec)
+	{
+		MutexLock lock(compressionMutex_);
+		CompressionStats& stats = compressionStats_[endpoint];
+		++stats.responses_;
+		stats.rawBytes_ += rawBytes;
+		stats.sentBytes_ += sentBytes;
+		stats.usec_ += usec;
+	}
+
+	HashMap<String, DevServer::CompressionStats> DevServer::GetCompressionStats() const
+	{
+		MutexLock lock(compressionMutex_);
+		return compressionStats_;
 	}
 
 	bool DevServer::IsServerLive() const
@@ -228,6 +698,16 @@ namespace Urho3D
 	void DevServer::AddHandler(DevServerHandler* handler)
 	{
 		handlers_.Push(handler);
+		InvalidateNavigation();
+
+		const unsigned registrations = router_.GetNumRegistrations();
+		handler->RegisterRoutes(router_);
+		if (router_.GetNumRegistrations() == registrations)
+		{
+			DevServerRoute legacy;
+			legacy.handler_ = handler;
+			legacyHandlers_.Push(legacy);
+		}
 	}
 
 	String DevServer::GetWebFile(const String& path) const
@@ -239,6 +719,23 @@ namespace Urho3D
 	}
 
 	String DevServer::GenerateNavigation() const
+	{
+		const unsigned generation = navGeneration_;
+		{
+			MutexLock lock(navMutex_);
+			if (navCacheGeneration_ == generation)
+				return navCache_;
+		}
+
+		String ret = BuildNavigation();
+
+		MutexLock lock(navMutex_);
+		navCache_ = ret;
+		navCacheGeneration_ = generation;
+		return ret;
+	}
+
+	String DevServer::BuildNavigation() const
 	{
 		String ret;
 		Vector<Pair<String, String>> titles;
@@ -247,7 +744,8 @@ namespace Urho3D
 			auto handler = handlers_[i];
 			handler->WriteNavigation(const_cast<DevServer*>(this), titles);
 		}
-		for (auto link : staticLinks_)
+		auto snapshot = AcquireSnapshot();
+		for (const auto& link : snapshot->staticLinks_)
 		{
 			ret += "<li class=\"nav-item\">";
 			ret += "<a class=\"nav-link\" href=\"" + link.second_ + "\">" + link.first_ + "</a>";
@@ -269,50 +767,41 @@ namespace Urho3D
 		if (mg_context* ctx = mg_get_context(conn))
 		{
 			DevServer* server = (DevServer*)mg_get_user_data(ctx);
+			HiresTimer timer;
 			auto requestInfo = mg_get_request_info(conn);
 			String uri(requestInfo->uri);
 			String query(requestInfo->query_string);
 
+			// query parameters go in first so route captures win on a name clash
 			VariantMap params;
+			ParseQueryString(query, params);
 
 			Vector<String> uriList = uri.Split('/');
 			if (strcmp("GET", requestInfo->request_method) == 0)
 			{
+				if (server->SendStaticAsset(conn, uri))
+					return 1;
+
 				if (uri.Empty() || uri == "/")
 				{
 					auto data = server->FillTemplate("template_page.html", {
 						{ "${TITLE}", "DebugServer is Live" },
 						{ "${BODY}", "<h3>Use the navigation above!</h3>" },
 					});
-					VectorBuffer buff;
-					buff.Write(data.CString(), data.Length());
-					SendDataResponse(conn, "text/html", buff);
+					SendHTMLResponse(conn, data);
 					return 1;
 				}
 				
-				// HTTP GET
-				for (auto handler : server->handlers_)
+				// HTTP GET, routed handlers first and then anything that only implements Handles
+				if (const DevServerRoute* route = server->router_.MatchGet(uriList, params))
 				{
-					if (handler->Handles(server, uriList))
-					{
-						if (DevServerDataHandler* datahandler = dynamic_cast<DevServerDataHandler*>(handler))
-						{
-							VectorBuffer buffer;
-							String mimeType;
-							if (datahandler->EmitData(server, uriList, mimeType, buffer))
-							{
-								buffer.Seek(0);
-								SendDataResponse(conn, mimeType, buffer);
-								return 1;
-							}
-						}
-						else
-						{
-							auto htmlData = handler->EmitHTML(server, uriList, params);
-							SendHTMLResponse(conn, htmlData);
-							return 1;
-						}
-					}
+					if (DispatchGet(conn, server, *route, uriList, params, timer))
+						return 1;
+				}
+				for (const auto& legacy : server->legacyHandlers_)
+				{
+					if (legacy.handler_->Handles(server, uriList) && DispatchGet(conn, server, legacy, uriList, params, timer))
+						return 1;
 				}
 			}
 			else
@@ -321,20 +810,84 @@ namespace Urho3D
 				char buffer[4096 * 8];
 				int bytesRead = mg_read(conn, buffer, 4096 * 8);
 				String buffText(buffer, bytesRead);
-				for (auto handler : server->handlers_)
+
+				DevServerHandler* target = nullptr;
+				String endpoint;
+				if (const DevServerRoute* route = server->router_.MatchPost(uriList, params))
 				{
-					if (handler->HandlesPost(server, uriList))
-					{
-						handler->DoPost(server, uriList, buffText);
-						SendHTMLResponse(conn, "Success");
-						return 1;
-					}
+					target = route->handler_;
+					endpoint = route->pattern_;
+				}
+				for (unsigned i = 0; !target && i < server->legacyHandlers_.Size(); ++i)
+				{
+					if (server->legacyHandlers_[i].handler_->HandlesPost(server, uriList))
+						target = server->legacyHandlers_[i].handler_;
+				}
+
+				if (target)
+				{
+					// match includes reading the body
+					DevRequestTiming timing;
+					timing.match_ = (unsigned)timer.GetUSec(false);
+					target->DoPost(server, uriList, buffText);
+					timing.emit_ = (unsigned)timer.GetUSec(false) - timing.match_;
+					const String reply = "Success";
+					SendHTMLResponse(conn, reply);
+					timing.total_ = (unsigned)timer.GetUSec(false);
+					timing.write_ = timing.total_ - timing.match_ - timing.emit_;
+					timing.bytes_ = reply.Length();
+					server->stats_.RecordRequest("POST " + (!endpoint.Empty() ? endpoint : (uriList.Empty() ? String("/") : uriList[0])), timing);
+					return 1;
 				}
 			}
 		}
 		return 0;
 	}
 
+	bool DevServer::DispatchGet(struct mg_connection* conn, DevServer* server, const DevServerRoute& route, const Vector<String>& uri, const VariantMap& params, HiresTimer& timer)
+	{
+		const String endpoint = !route.pattern_.Empty() ? route.pattern_ : (uri.Empty() ? String("/") : uri[0]);
+		DevRequestTiming timing;
+
+		// the weak tag covers every content-coding of the same page
+		const String tag = route.handler_->GetETag(server, uri, params);
+		const String etag = tag.Empty() ? String() : "W/\"" + tag + "\"";
+		if (!etag.Empty() && MatchesETag(conn, etag))
+		{
+			SendNotModified(conn, etag);
+			timing.match_ = timing.total_ = (unsigned)timer.GetUSec(false);
+			timing.notModified_ = true;
+			server->stats_.RecordRequest(endpoint, timing);
+			return true;
+		}
+		timing.match_ = (unsigned)timer.GetUSec(false);
+
+		DevServerResponse response(conn);
+		if (!etag.Empty())
+		{
+			response.AddHeader("ETag", etag);
+			response.AddHeader("Cache-Control", "no-cache");
+		}
+		if (server->compressionEnabled_)
+			response.EnableCompression(NegotiateEncoding(mg_get_header(conn, "Accept-Encoding")), server->compressionThreshold_, DYNAMIC_COMPRESSION_QUALITY);
+		// a declining handler hasn't written anything, the request falls through to the 404 page
+		if (!route.handler_->Emit(server, uri, params, response))
+		{
+			response.Cancel();
+			return false;
+		}
+		response.Finish();
+
+		// emit is what's left once routing and socket writes are taken out, so it includes compressing the body
+		timing.total_ = (unsigned)timer.GetUSec(false);
+		timing.write_ = (unsigned)response.GetWriteTime();
+		timing.emit_ = timing.total_ - Min(timing.total_, timing.match_ + timing.write_);
+		timing.bytes_ = response.GetSentSize();
+		server->stats_.RecordRequest(endpoint, timing);
+		server->RecordCompression(endpoint, response.GetBodySize(), response.GetSentSize(), response.GetCompressionTime());
+		return true;
+	}
+
 	int DevServer::SendErrorPage(struct mg_connection* conn, int status)
 	{
 		if (mg_context* ctx = mg_get_context(conn))
@@ -344,10 +897,34 @@ namespace Urho3D
 		return 1;
 	}
 
+	bool DevServer::MatchesETag(struct mg_connection* conn, const String& etag)
+	{
+		const char* ifNoneMatch = mg_get_header(conn, "If-None-Match");
+		if (ifNoneMatch == nullptr)
+			return false;
+
+		// weak comparison, the W/ prefix doesn't matter
+		const String opaque = etag.StartsWith("W/") ? etag.Substring(2) : etag;
+		Vector<String> tags = String(ifNoneMatch).Split(',');
+		for (auto tag : tags)
+		{
+			tag = tag.Trimmed();
+			if (tag.StartsWith("W/"))
+				tag = tag.Substring(2);
+			if (tag == opaque || tag == "*")
+				return true;
+		}
+		return false;
+	}
+
+	void DevServer::SendNotModified(struct mg_connection* conn, const String& etag)
+	{
+		mg_printf(conn, "HTTP/1.1 304 Not Modified\r\nETag: %s\r\nCache-Control: no-cache\r\n\r\n", etag.CString());
+	}
+
 	void DevServer::SendHTMLResponse(struct mg_connection* conn, const String& html)
 	{
-		String rsp = "HTTP/1.1 200 OK\r\nContent-type: text/html\r\n\r\n";
-		mg_write(conn, rsp.CString(), rsp.Length());
+		mg_printf(conn, "HTTP/1.1 200 OK\r\nContent-type: text/html\r\nContent-length: %u\r\n\r\n", html.Length());
 		mg_write(conn, html.CString(), html.Length());
 	}
 
@@ -359,99 +936,483 @@ namespace Urho3D
 
 	void DevServer::AddDeferredCommand(std::function<void()> cmd)
 	{
-		MutexLock lock(mutex_);
-		deferredCommand_.push_back(cmd);
+		commandQueue_.Push(std::move(cmd));
 	}
 
 	void DevServer::OnNewFrame(StringHash, VariantMap&)
 	{
-		MutexLock lock(mutex_);
-		for (unsigned i = 0; i < deferredCommand_.size(); ++i)
-			deferredCommand_[i]();
-		deferredCommand_.clear();
+		HiresTimer timer;
+		metrics_.BeginFrame();
+		// the profiler has just closed the previous frame, its blocks still hold that frame's times
+		if (Profiler* profiler = GetSubsystem<Profiler>())
+			profiler_.Capture(profiler);
+		commandQueue_.Run(commandBudget_);
+		SettleHistory();
+		UpdateSnapshot();
+		watchHub_->Update();
+		stats_.RecordFrame((unsigned)timer.GetUSec(false));
 	}
 
-	void DevServer::OnLog(StringHash, VariantMap& data)
+	Scene* DevServer::FindScene(const String& slug) const
 	{
-		using namespace LogMessage;
-		int logLevel = data[P_LEVEL].GetInt();
-		String logMsg = data[P_MESSAGE].GetString();
-
-		String logHTML;
-		switch (logLevel) {
-		case LOG_DEBUG:
-			logHTML = "<div class=\"alert alert-primary\">" + logMsg + "</div>";
-			break;
-		case LOG_WARNING:
-			logHTML = "<div class=\"alert alert-warning\">" + logMsg + "</div>";
-			break;
-		case LOG_ERROR:
-			logHTML = "<div class=\"alert alert-danger\">" + logMsg + "</div>";
-			break;
-		case LOG_INFO:
-			logHTML = "<div class=\"alert alert-secondary\">" + logMsg + "</div>";
-			break;
-		}
-		log_.Push(logHTML);
+		auto found = sceneSlugs_.Find(slug.ToLower());
+		return found != sceneSlugs_.End() ? GetScene(found->second_) : nullptr;
 	}
 
-	bool DevServer::LogHandler::Handles(DevServer*, const Vector<String>& uri)
+	Scene* DevServer::GetScene(unsigned id) const
 	{
-		return uri.Size() > 0 &&  uri[0].Compare("Log", false) == 0;
+		auto found = scenes_.Find(id);
+		return found != scenes_.End() ? found->second_.scene_.Get() : nullptr;
 	}
 
-	String DevServer::LogHandler::EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params)
+	const String& DevServer::GetSceneSlug(unsigned id) const
 	{
-		String ret;
+		auto found = scenes_.Find(id);
+		return found != scenes_.End() ? found->second_.slug_ : String::EMPTY;
+	}
 
-		auto logCopy = server->log_;
-		for (int i = logCopy.Size() - 1; i >= 0; --i)
-			ret += logCopy[i];
+	bool DevServer::RunOnMainThread(std::function<void()> work, unsigned timeoutMs)
+	{
+		// shared by the waiting request and the queued command, either may outlive the other
+		struct Job {
+			std::mutex mutex_;
+			std::condition_variable done_;
+			bool started_ = false;
+			bool finished_ = false;
+			bool abandoned_ = false;
+		};
+		auto job = std::make_shared<Job>();
+		AddDeferredCommand([job, work]() {
+			{
+				std::lock_guard<std::mutex> lock(job->mutex_);
+				if (job->abandoned_)
+					return;
+				job->started_ = true;
+			}
+			work();
+			std::lock_guard<std::mutex> lock(job->mutex_);
+			job->finished_ = true;
+			job->done_.notify_all();
+		});
 
-		return server->FillTemplate( "template_page.html", {
-				{ "${TITLE}", "Urho3D Log" },
-				{ "${BODY}", ret },
-			});
+		std::unique_lock<std::mutex> lock(job->mutex_);
+		if (job->done_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&job] { return job->finished_; }))
+			return true;
+		// work that has started is only ever a frame's worth away from done, and its results are about to be complete
+		if (job->started_)
+		{
+			job->done_.wait(lock, [&job] { return job->finished_; });
+			return true;
+		}
+		job->abandoned_ = true;
+		return false;
 	}
 
-	void DevServer::LogHandler::WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI)
+	void DevServer::QueuePageBroadcast(const String& title)
 	{
-		titleAndURI.Push(Pair<String, String>("Log", "/Log"));
+		if (!pendingPageBroadcasts_.Contains(title))
+			pendingPageBroadcasts_.Push(title);
+		snapshotDirty_ = true;
 	}
 
-	void DevServer::StandardHeader(const String& title, String& holder) const
+	unsigned DevServer::AddScene(Scene* scene)
 	{
-		holder += "<html><head><title>" + title + "</title>";
-		holder += "<link href=\"/css/bootstrap.min.css\" rel=\"stylesheet\">";
-		holder += "</head><body style=\"margin: 10px\">";
-		holder += "<h1>" + title + "</h1>";
+		if (!scene)
+			return 0;
+		for (const auto& entry : scenes_)
+		{
+			if (entry.second_.scene_.Get() == scene)
+				return entry.first_;
+		}
+
+		RegisteredScene entry;
+		entry.scene_ = scene;
+		entry.id_ = nextSceneId_++;
+		entry.slug_ = MakeSceneSlug(scene->GetName());
+		if (sceneSlugs_.Contains(entry.slug_.ToLower()))
+			entry.slug_ += "_" + String(entry.id_);
+		entry.index_ = new DevSceneIndex(context_, scene);
+		sceneSlugs_[entry.slug_.ToLower()] = entry.id_;
+		scenes_[entry.id_] = entry;
+		snapshotDirty_ = true;
+		navigationDirty_ = true;
+		return entry.id_;
 	}
-	void DevServer::StandardFooter(String& holder) const
+
+	void DevServer::RemoveScene(Scene* scene)
 	{
-		holder += "<script src=\"/js/jquery.js\"></script>";
-		holder += "<script src=\"/js/bootstrap.min.js\"></script>";
-		holder += "</body></html>";
+		for (auto i = scenes_.Begin(); i != scenes_.End(); ++i)
+		{
+			if (i->second_.scene_.Get() == scene)
+			{
+				// snapshots still holding the index keep it alive until they're retired
+				sceneSlugs_.Erase(i->second_.slug_.ToLower());
+				scenes_.Erase(i);
+				snapshotDirty_ = true;
+				navigationDirty_ = true;
+				return;
+			}
+		}
 	}
-	void DevServer::CollapsibleList(String& holder, const String& header, const StringVector& items, const String& key) const
-	{
-		holder += "<div class=\"panel-group\" id=\"" + key + "\">";
-			holder += "<div class=\"panel panel-default\">";
-		
-				holder += "<div class=\"panel-heading\"><h4 class=\"panel-title\"><a data-toggle=\"collapse\" href=\"#" + key + "_target\">" + header + "</a></h4></div>";
-				holder += "<div id=\"" + key + "_target\" class=\"panel-collapse collapse\">";
-				holder += "<ul class=\"list-group\">";
-				for (auto item : items)
-					holder += "<li class=\"list-group-item\">" + item + "</li>";
-				holder += "</ul>";
-				holder += "</div>";
 
-		holder += "</div>";
-		holder += "</div>";
-	}
-	String DevServer::Accordian(const String& key, const String& title, const String& content) const
+	void DevServer::UpdateSnapshot()
 	{
-		String holder;
-		holder += "<div class=\"panel-group\" id=\"" + key + "\">";
+		// the last reference to a retired snapshot is ours once no request holds it
+		for (unsigned i = 0; i < retiredSnapshots_.Size();)
+		{
+			if (retiredSnapshots_[i].use_count() == 1)
+				retiredSnapshots_.Erase(i);
+			else
+				++i;
+		}
+
+		// scenes are held weakly, a destroyed one is dropped here along with its slug
+		for (auto i = scenes_.Begin(); i != scenes_.End();)
+		{
+			if (i->second_.scene_)
+			{
+				++i;
+				continue;
+			}
+			sceneSlugs_.Erase(i->second_.slug_.ToLower());
+			i = scenes_.Erase(i);
+			snapshotDirty_ = true;
+			navigationDirty_ = true;
+		}
+
+		std::shared_ptr<const Snapshot> current = AcquireSnapshot();
+		// scenes can be renamed at any time, the menu shows their current names
+		if (current && !snapshotDirty_)
+		{
+			unsigned index = 0;
+			for (const auto& entry : scenes_)
+			{
+				if (current->scenes_[index].name_ != entry.second_.scene_->GetName())
+				{
+					snapshotDirty_ = true;
+					navigationDirty_ = true;
+					break;
+				}
+				++index;
+			}
+		}
+		if (current && !snapshotDirty_)
+			return;
+
+		auto snapshot = std::make_shared<Snapshot>();
+		snapshot->version_ = current ? current->version_ + 1 : 1;
+		for (const auto& page : simpleTexts_)
+		{
+			std::shared_ptr<const StaticItem>& shared = snapshotPages_[page.first_];
+			if (!shared || shared->version_ != page.second_.version_ || shared->image_ != page.second_.image_)
+				shared = std::make_shared<const StaticItem>(page.second_);
+			snapshot->pages_.Insert(MakePair(page.first_, shared));
+		}
+		for (const auto& entry : scenes_)
+		{
+			snapshot->sceneSlugs_[entry.second_.slug_.ToLower()] = snapshot->scenes_.Size();
+			snapshot->scenes_.Push({ entry.first_, entry.second_.index_, entry.second_.scene_->GetName(), entry.second_.slug_ });
+		}
+		for (const auto& command : commands_)
+		{
+			CommandItem item;
+			item.title_ = command.title_;
+			item.tip_ = command.tip_;
+			item.url_ = command.url_;
+			snapshot->commands_.push_back(item);
+		}
+		snapshot->staticLinks_ = staticLinks_;
+
+		std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(snapshot));
+		if (current)
+			retiredSnapshots_.Push(current);
+		snapshotDirty_ = false;
+		// a republished page keeps its menu entry, leaving the generation alone keeps the ETags of pages that show the menu valid
+		if (navigationDirty_)
+		{
+			navigationDirty_ = false;
+			InvalidateNavigation();
+		}
+
+		for (const auto& title : pendingPageBroadcasts_)
+		{
+			auto found = simpleTexts_.Find(title);
+			if (found != simpleTexts_.End())
+				BroadcastPage(title, found->second_);
+		}
+		pendingPageBroadcasts_.Clear();
+	}
+
+	const DevServer::StaticItem* DevServer::Snapshot::FindPage(const String& title) const
+	{
+		auto found = pages_.Find(title);
+		return found != pages_.End() ? found->second_.get() : nullptr;
+	}
+
+	const DevServer::StaticItem* DevServer::Snapshot::FindImage(const String& page, String& title) const
+	{
+		if (!page.EndsWith(".png", false))
+			return nullptr;
+		title = page.Substring(0, page.Length() - 4);
+		const StaticItem* item = FindPage(title);
+		return item && item->image_ ? item : nullptr;
+	}
+
+	const DevServer::Snapshot::SceneEntry* DevServer::Snapshot::FindScene(const String& slug) const
+	{
+		auto found = sceneSlugs_.Find(slug.ToLower());
+		return found != sceneSlugs_.End() ? &scenes_[found->second_] : nullptr;
+	}
+
+	String DevServer::MakeSceneSlug(const String& name)
+	{
+		String slug = name.Trimmed();
+		if (slug.Empty())
+			return "Unnamed_scene";
+		for (unsigned i = 0; i < slug.Length(); ++i)
+		{
+			const char c = slug[i];
+			if (!IsAlpha((unsigned)(unsigned char)c) && !IsDigit((unsigned)(unsigned char)c) && c != '-' && c != '_')
+				slug[i] = '_';
+		}
+		return slug;
+	}
+
+	void DevServer::OnResourceReloaded(StringHash, VariantMap&)
+	{
+		++resourceGeneration_;
+	}
+
+	/// A log entry as the [sequence, level, time, message] array used by /Log queries and /Stream/Log.
+	static void WriteLogEntryJSON(DevServerJSONWriter& writer, const DevServerLogEntry& entry)
+	{
+		writer.BeginArray();
+		writer.Value(entry.sequence_);
+		writer.Value(entry.level_);
+		writer.Value(entry.time_);
+		writer.Value(entry.message_);
+		writer.EndArray();
+	}
+
+	static String LogEntryToJSON(const DevServerLogEntry& entry)
+	{
+		DevServerJSONWriter writer(entry.message_.Length() + 48);
+		WriteLogEntryJSON(writer, entry);
+		return writer.Detach();
+	}
+
+	void DevServer::OnLog(StringHash, VariantMap& data)
+	{
+		using namespace LogMessage;
+		HiresTimer timer;
+		int logLevel = data[P_LEVEL].GetInt();
+		const String& logMsg = data[P_MESSAGE].GetString();
+
+		logRing_.Push(logLevel, Time::GetTimeSinceEpoch(), logMsg);
+
+		if (streamHub_.HasClients(STREAM_LOG))
+		{
+			DevServerLogEntry entry;
+			if (logRing_.Read(logRing_.GetLastSequence(), entry))
+				streamHub_.Broadcast(STREAM_LOG, "log", LogEntryToJSON(entry), entry.sequence_);
+		}
+		stats_.RecordLog((unsigned)timer.GetUSec(false));
+	}
+
+	void DevServer::LogHandler::RegisterRoutes(DevServerRouter& router)
+	{
+		router.Get("Log", this);
+	}
+
+	bool DevServer::LogHandler::Handles(DevServer*, const Vector<String>& uri)
+	{
+		return uri.Size() > 0 &&  uri[0].Compare("Log", false) == 0;
+	}
+
+	/// Bootstrap alert class for a log level.
+	static const char* LogLevelClass(int level)
+	{
+		switch (level)
+		{
+		case LOG_DEBUG:
+			return "alert-primary";
+		case LOG_WARNING:
+			return "alert-warning";
+		case LOG_ERROR:
+			return "alert-danger";
+		case LOG_INFO:
+			return "alert-secondary";
+		default:
+			return "alert-light";
+		}
+	}
+
+	/// Default and largest number of entries returned by a log query.
+	static const unsigned LOG_QUERY_LIMIT = 500;
+	static const unsigned LOG_QUERY_MAX_LIMIT = 5000;
+
+	/// Renders the retained log newest first, T is a String or DevServerResponse.
+	template<typename T>
+	static void WriteLogEntries(const DevServerLogRing& ring, int minLevel, T& out)
+	{
+		DevServerLogEntry entry;
+		const unsigned long long first = ring.GetFirstSequence();
+		for (unsigned long long seq = ring.GetLastSequence(); seq >= first && seq > 0; --seq)
+		{
+			if (!ring.Read(seq, entry) || entry.level_ < minLevel)
+				continue;
+			out += "<div class=\"alert ";
+			out += LogLevelClass(entry.level_);
+			out += "\">";
+			out += EscapeHTML(entry.message_);
+			out += "</div>";
+		}
+	}
+
+	/// Level filter links and the script that prepends new entries, live from /Stream/Log or by polling /Log?since= without EventSource.
+	static String LogPageControls(unsigned long long cursor, int minLevel)
+	{
+		String html;
+		html += "<div class=\"btn-group\" style=\"margin-bottom: 10px\">";
+		const char* levelNames[] = { "All", "Info", "Warning", "Error" };
+		for (int i = 0; i < 4; ++i)
+			html += ToString("<a class=\"btn btn-sm %s\" href=\"/Log?level=%d\">%s</a>", i == minLevel ? "btn-secondary" : "btn-outline-secondary", i, levelNames[i]);
+		html += "</div>";
+		html += "<script>";
+		html += ToString("var logCursor = %llu; var logLevel = %d;", cursor, minLevel);
+		html += "var logClasses = ['alert-primary', 'alert-secondary', 'alert-warning', 'alert-danger'];";
+		html += "function addLog(e) {";
+		html += "  if (e[0] <= logCursor) return;";
+		html += "  logCursor = e[0];";
+		html += "  if (e[1] >= logLevel) $('#log').prepend($('<div>').addClass('alert ' + (logClasses[e[1]] || 'alert-light')).text(e[3]));";
+		html += "}";
+		html += "function pollLog() {";
+		html += "  $.getJSON('/Log?since=' + logCursor + '&level=' + logLevel, function(data) {";
+		html += "    data.entries.forEach(addLog);";
+		html += "    logCursor = Math.max(logCursor, data.next);";
+		html += "  }).always(function() { setTimeout(pollLog, 1000); });";
+		html += "}";
+		html += "if (window.EventSource) {";
+		html += "  var logStream = new EventSource('/Stream/Log?since=' + logCursor + '&level=' + logLevel);";
+		html += "  logStream.addEventListener('log', function(msg) { addLog(JSON.parse(msg.data)); });";
+		html += "} else {";
+		html += "  setTimeout(pollLog, 1000);";
+		html += "}";
+		html += "</script>";
+		return html;
+	}
+
+	String DevServer::LogHandler::EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params)
+	{
+		const int minLevel = ToInt(GetURIParam(params, "level", "0"));
+		const unsigned long long cursor = server->logRing_.GetLastSequence();
+		String ret = LogPageControls(cursor, minLevel);
+		ret += "<div id=\"log\">";
+		WriteLogEntries(server->logRing_, minLevel, ret);
+		ret += "</div>";
+
+		return server->FillTemplate( "template_page.html", {
+				{ "${TITLE}", "Urho3D Log" },
+				{ "${BODY}", ret },
+			});
+	}
+
+	bool DevServer::LogHandler::Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response)
+	{
+		if (params.Contains("since"))
+			return EmitQuery(server, params, response);
+
+		const int minLevel = ToInt(GetURIParam(params, "level", "0"));
+		const unsigned long long cursor = server->logRing_.GetLastSequence();
+		server->WriteTemplate(response, "template_page.html", { { "${TITLE}", "Urho3D Log" } }, [&](DevServerResponse& rsp) {
+			rsp += LogPageControls(cursor, minLevel);
+			rsp += "<div id=\"log\">";
+			WriteLogEntries(server->logRing_, minLevel, rsp);
+			rsp += "</div>";
+		});
+		return true;
+	}
+
+	bool DevServer::LogHandler::EmitQuery(DevServer* server, const VariantMap& params, DevServerResponse& response)
+	{
+		const unsigned long long since = strtoull(GetURIParam(params, "since").CString(), nullptr, 10);
+		const int minLevel = ToInt(GetURIParam(params, "level", "0"));
+		unsigned limit = ToUInt(GetURIParam(params, "limit", String(LOG_QUERY_LIMIT)));
+		if (limit == 0 || limit > LOG_QUERY_MAX_LIMIT)
+			limit = LOG_QUERY_MAX_LIMIT;
+
+		const DevServerLogRing& ring = server->logRing_;
+		Vector<DevServerLogEntry> entries;
+		const unsigned long long next = ring.ReadSince(since, minLevel, limit, entries);
+
+		// entries are [sequence, level, time, message]
+		DevServerJSONWriter writer(256 + entries.Size() * 96);
+		writer.BeginObject();
+		writer.Key("first");
+		writer.Value(ring.GetFirstSequence());
+		writer.Key("last");
+		writer.Value(ring.GetLastSequence());
+		writer.Key("next");
+		writer.Value(next);
+		writer.Key("entries");
+		writer.BeginArray();
+		for (const auto& entry : entries)
+			WriteLogEntryJSON(writer, entry);
+		writer.EndArray();
+		writer.EndObject();
+
+		response.SetContentType("application/json");
+		response.AddHeader("Cache-Control", "no-cache");
+		response += writer.GetBuffer();
+		return true;
+	}
+
+	String DevServer::LogHandler::GetETag(DevServer* server, const Vector<String>& uri, const VariantMap& params)
+	{
+		// queries are already deltas
+		if (params.Contains("since"))
+			return String();
+		return ToString("l%llu-v%d-n%u", server->logRing_.GetLastSequence(), ToInt(GetURIParam(params, "level", "0")), server->GetNavigationGeneration());
+	}
+
+	void DevServer::LogHandler::WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI)
+	{
+		titleAndURI.Push(Pair<String, String>("Log", "/Log"));
+	}
+
+	void DevServer::StandardHeader(const String& title, String& holder) const
+	{
+		holder += "<html><head><title>" + title + "</title>";
+		holder += "<link href=\"/css/bootstrap.min.css\" rel=\"stylesheet\">";
+		holder += "</head><body style=\"margin: 10px\">";
+		holder += "<h1>" + title + "</h1>";
+	}
+	void DevServer::StandardFooter(String& holder) const
+	{
+		holder += "<script src=\"/js/jquery.js\"></script>";
+		holder += "<script src=\"/js/bootstrap.min.js\"></script>";
+		holder += "</body></html>";
+	}
+	void DevServer::CollapsibleList(String& holder, const String& header, const StringVector& items, const String& key) const
+	{
+		holder += "<div class=\"panel-group\" id=\"" + key + "\">";
+			holder += "<div class=\"panel panel-default\">";
+		
+				holder += "<div class=\"panel-heading\"><h4 class=\"panel-title\"><a data-toggle=\"collapse\" href=\"#" + key + "_target\">" + header + "</a></h4></div>";
+				holder += "<div id=\"" + key + "_target\" class=\"panel-collapse collapse\">";
+				holder += "<ul class=\"list-group\">";
+				for (auto item : items)
+					holder += "<li class=\"list-group-item\">" + item + "</li>";
+				holder += "</ul>";
+				holder += "</div>";
+
+		holder += "</div>";
+		holder += "</div>";
+	}
+	String DevServer::Accordian(const String& key, const String& title, const String& content) const
+	{
+		String holder;
+		holder += "<div class=\"panel-group\" id=\"" + key + "\">";
 		holder += "<div class=\"panel panel-default\">";
 		holder += "<div class=\"panel-heading\"><h4 class=\"panel-title\"><a data-toggle=\"collapse\" href=\"#" + key + "_target\">" + title + "</a></h4></div>";
 		holder += "<div id=\"" + key + "_target\" class=\"panel-collapse collapse\">";
@@ -470,11 +1431,103 @@ namespace Urho3D
 	}
 	String DevServer::FillTemplate(const String& templateFile, const HashMap<String, String>& items) const
 	{
-		String templateData = GetWebFile(templateFile);
-		templateData.Replace("${MENU}", GenerateNavigation());
-		for (auto entry : items)
-			templateData.Replace(entry.first_, entry.second_);
-		return templateData;
+		auto compiled = GetTemplate(templateFile);
+		const auto& segments = compiled->segments_;
+
+		// resolve every placeholder first so the output can be sized once
+		PODVector<const String*> values(segments.Size());
+		String menu;
+		unsigned length = compiled->literalLength_;
+		for (unsigned i = 0; i < segments.Size(); ++i)
+		{
+			values[i] = &segments[i].text_;
+			if (!segments[i].placeholder_)
+				continue;
+
+			if (segments[i].text_ == "${MENU}")
+			{
+				if (menu.Empty())
+					menu = GenerateNavigation();
+				values[i] = &menu;
+			}
+			else
+			{
+				auto found = items.Find(segments[i].text_);
+				if (found != items.End())
+					values[i] = &found->second_;
+			}
+			length += values[i]->Length();
+		}
+
+		String ret;
+		ret.Reserve(length);
+		for (unsigned i = 0; i < values.Size(); ++i)
+			ret.Append(*values[i]);
+		return ret;
+	}
+
+	void DevServer::WriteTemplate(DevServerResponse& response, const String& templateFile, const HashMap<String, String>& items, const std::function<void(DevServerResponse&)>& bodyWriter) const
+	{
+		auto compiled = GetTemplate(templateFile);
+		for (const auto& segment : compiled->segments_)
+		{
+			if (!segment.placeholder_)
+				response += segment.text_;
+			else if (segment.text_ == "${MENU}")
+				response += GenerateNavigation();
+			else if (bodyWriter && segment.text_ == "${BODY}")
+				bodyWriter(response);
+			else
+			{
+				auto found = items.Find(segment.text_);
+				response += found != items.End() ? found->second_ : segment.text_;
+			}
+		}
+	}
+
+	std::shared_ptr<const DevServer::CompiledTemplate> DevServer::GetTemplate(const String& templateFile) const
+	{
+		const unsigned now = Time::GetSystemTime();
+
+		MutexLock lock(templateMutex_);
+		TemplateEntry& entry = templates_[templateFile];
+		if (entry.template_ && now - entry.checkedTime_ < TEMPLATE_CHECK_INTERVAL_MS)
+			return entry.template_;
+		entry.checkedTime_ = now;
+
+		const auto path = GetContext()->GetSubsystem<FileSystem>()->GetProgramDir() + "web/" + templateFile;
+		const unsigned modified = GetContext()->GetSubsystem<FileSystem>()->GetLastModifiedTime(path);
+		if (entry.template_ && modified == entry.modifiedTime_)
+			return entry.template_;
+
+		const String source = GetWebFile(templateFile);
+		auto compiled = std::make_shared<CompiledTemplate>();
+		compiled->literalLength_ = 0;
+		unsigned pos = 0;
+		while (pos < source.Length())
+		{
+			const unsigned start = source.Find("${", pos);
+			const unsigned end = start != String::NPOS ? source.Find('}', start + 2) : String::NPOS;
+			if (end == String::NPOS)
+				break;
+
+			if (start > pos)
+			{
+				compiled->segments_.Push({ source.Substring(pos, start - pos), false });
+				compiled->literalLength_ += start - pos;
+			}
+			compiled->segments_.Push({ source.Substring(start, end - start + 1), true });
+			pos = end + 1;
+		}
+		if (pos < source.Length())
+		{
+			compiled->segments_.Push({ source.Substring(pos), false });
+			compiled->literalLength_ += source.Length() - pos;
+		}
+
+		entry.template_ = compiled;
+		entry.modifiedTime_ = modified;
+		return entry.template_;
 	}
 
 	void DevServer::Publish(const String& title, const String& content)
@@ -482,22 +1535,328 @@ namespace Urho3D
 		StaticItem item;
 		item.text_ = content;
 		item.timeStamp_ = Time::GetTimeStamp();
+		item.version_ = ++publishCounter_;
 
+		// only a new title changes the menu
+		if (!simpleTexts_.Contains(title))
+			navigationDirty_ = true;
+		ReleasePublishedImage(title);
+		ClearHistory(title);
 		simpleTexts_.Insert(Pair<String,StaticItem>(title, item));
+		QueuePageBroadcast(title);
+	}
+
+	void DevServer::Publish(const String& title, const SharedPtr<Image>& content)
+	{
+		StaticItem item;
+		item.image_ = content;
+		item.timeStamp_ = Time::GetTimeStamp();
+		item.version_ = ++publishCounter_;
+
+		// this publisher is known to edit its image after publishing, a deferred copy would see the next step
+		if (historyFrames_ && content && retainedTitles_.Contains(title))
+		{
+			if (SharedPtr<Image> copy = CopyImage(content))
+				item.image_ = copy;
+		}
+
+		if (!simpleTexts_.Contains(title))
+			navigationDirty_ = true;
+		ReleasePublishedImage(title);
+		simpleTexts_.Insert(Pair<String, StaticItem>(title, item));
+		if (historyFrames_ && item.image_)
+			RecordHistory(title, item);
+		QueuePageBroadcast(title);
+	}
+
+	void DevServer::Publish(const String& title, const float* pixels, unsigned width, unsigned height, unsigned components)
+	{
+		if (!pixels || !width || !height || components < 1 || components > 4)
+			return;
+
+		PODVector<unsigned char> converted;
+		ConvertFloatPreview(pixels, width, height, components, converted);
+		SharedPtr<Image> image(new Image(GetContext()));
+		image->SetSize(width, height, components);
+		image->SetData(converted.Buffer());
+		Publish(title, image);
+	}
+
+	DevServer::EncodedImage DevServer::GetPublishedPNG(const String& title, unsigned version, const Image* image)
+	{
+		{
+			MutexLock lock(encodedImagesMutex_);
+			auto found = encodedImages_.Find(title);
+			if (found != encodedImages_.End() && found->second_.first_ == version)
+				return found->second_.second_;
+		}
+
+		// encoded outside the lock, two requests racing for a new image both encode and the first one in is kept
+		DevImagePreview preview;
+		auto encoded = std::make_shared<PODVector<unsigned char>>();
+		if (!GetImagePreview(image, preview) || !EncodeImage(preview.pixels_, preview.width_, preview.height_, preview.components_, DIF_PNG, DEFAULT_IMAGE_LEVEL, *encoded))
+			return nullptr;
+
+		// one entry per title, so a request that finishes after its version was replaced can't leave anything behind for good,
+		// and an older version never displaces a newer one
+		MutexLock lock(encodedImagesMutex_);
+		Pair<unsigned, EncodedImage>& cached = encodedImages_[title];
+		if (cached.first_ == version && cached.second_)
+			return cached.second_;
+		if (!cached.second_ || cached.first_ < version)
+			cached = MakePair(version, EncodedImage(encoded));
+		return encoded;
+	}
+
+	void DevServer::ReleasePublishedImage(const String& title)
+	{
+		auto previous = simpleTexts_.Find(title);
+		if (previous == simpleTexts_.End() || !previous->second_.image_)
+			return;
+		MutexLock lock(encodedImagesMutex_);
+		encodedImages_.Erase(title);
+	}
+
+	void DevServer::SetPublishHistory(unsigned framesPerTitle, unsigned long long byteBudget)
+	{
+		MutexLock lock(historyMutex_);
+		historyFrames_ = framesPerTitle;
+		historyBudget_ = byteBudget;
+		if (!historyFrames_)
+		{
+			for (auto& pair : history_)
+				RetireHistory(pair.second_);
+			history_.Clear();
+			retainedTitles_.Clear();
+			historyBytes_ = 0;
+		}
+		else
+			EvictHistory();
+	}
+
+	void DevServer::RecordHistory(const String& title, const StaticItem& item)
+	{
+		MutexLock lock(historyMutex_);
+		Vector<HistoryFrame>& frames = history_[title];
+
+		HistoryFrame frame;
+		frame.image_ = HoldImage(item.image_);
+		frame.timeStamp_ = item.timeStamp_;
+		frame.version_ = item.version_;
+		frame.size_ = item.image_->GetMemoryUse();
+		frame.lastUsed_ = ++historyTick_;
+		frame.pending_ = !retainedTitles_.Contains(title);
+
+		// the same image published twice in a frame has been edited in between, the earlier frame already shows the edit
+		for (const auto& previous : frames)
+		{
+			if (previous.pending_ && previous.image_.get() == item.image_.Get())
+				retainedTitles_.Insert(title);
+		}
+
+		frames.Push(frame);
+		historyBytes_ += frame.size_;
+		EvictHistory();
+	}
+
+	void DevServer::SettleHistory()
+	{
+		MutexLock lock(historyMutex_);
+		for (unsigned i = 0; i < retiredHistory_.Size();)
+		{
+			if (retiredHistory_[i].use_count() == 1)
+				retiredHistory_.Erase(i);
+			else
+				++i;
+		}
+
+		for (auto& pair : history_)
+		{
+			auto latest = simpleTexts_.Find(pair.first_);
+			for (auto& frame : pair.second_)
+			{
+				if (!frame.pending_)
+					continue;
+				frame.pending_ = false;
+
+				// references of our own are the frame's and the published item's when this is the latest version
+				const bool isLatest = latest != simpleTexts_.End() && latest->second_.version_ == frame.version_;
+				const int held = isLatest ? 2 : 1;
+				if (frame.image_->Refs() <= held)
+					continue;
+
+				// the publisher still holds the image and may write to it, this is the last safe moment to copy
+				SharedPtr<Image> copy = CopyImage(frame.image_.get());
+				if (!copy)
+					continue;
+				retainedTitles_.Insert(pair.first_);
+				if (isLatest)
+				{
+					latest->second_.image_ = copy;
+					snapshotDirty_ = true;
+				}
+				// a compressed image comes back as RGBA, the budget has to count what's actually kept
+				historyBytes_ -= frame.size_;
+				frame.size_ = copy->GetMemoryUse();
+				historyBytes_ += frame.size_;
+				frame.image_ = HoldImage(copy);
+			}
+		}
+
+		if (historyBytes_ > historyBudget_)
+			EvictHistory();
+	}
+
+	void DevServer::EvictHistory()
+	{
+		// a frame a request is sending is skipped and retried on the next eviction
+		auto drop = [this](const String& title, Vector<HistoryFrame>& frames, unsigned index) {
+			if (frames[index].image_.use_count() > 1)
+				return false;
+			historyBytes_ -= frames[index].size_;
+			{
+				// the cache holds the newest version encoded for the title, which may be this one
+				MutexLock lock(encodedImagesMutex_);
+				auto cached = encodedImages_.Find(title);
+				if (cached != encodedImages_.End() && cached->second_.first_ == frames[index].version_)
+					encodedImages_.Erase(cached);
+			}
+			frames.Erase(index);
+			return true;
+		};
+
+		for (auto& pair : history_)
+		{
+			Vector<HistoryFrame>& frames = pair.second_;
+			for (unsigned i = 0; i + 1 < frames.Size() && frames.Size() > historyFrames_;)
+			{
+				if (!drop(pair.first_, frames, i))
+					++i;
+			}
+		}
+
+		while (historyBytes_ > historyBudget_)
+		{
+			const String* oldestTitle = nullptr;
+			Vector<HistoryFrame>* oldestFrames = nullptr;
+			unsigned oldestIndex = 0;
+			for (auto& pair : history_)
+			{
+				// the latest frame of a title is what its page shows, it's never evicted
+				for (unsigned i = 0; i + 1 < pair.second_.Size(); ++i)
+				{
+					const HistoryFrame& frame = pair.second_[i];
+					if (frame.image_.use_count() > 1)
+						continue;
+					if (!oldestFrames || (int)(frame.lastUsed_ - (*oldestFrames)[oldestIndex].lastUsed_) < 0)
+					{
+						oldestTitle = &pair.first_;
+						oldestFrames = &pair.second_;
+						oldestIndex = i;
+					}
+				}
+			}
+			if (!oldestFrames)
+				break;
+			drop(*oldestTitle, *oldestFrames, oldestIndex);
+		}
+	}
+
+	void DevServer::ClearHistory(const String& title)
+	{
+		MutexLock lock(historyMutex_);
+		auto found = history_.Find(title);
+		if (found == history_.End())
+			return;
+		for (const auto& frame : found->second_)
+			historyBytes_ -= frame.size_;
+		RetireHistory(found->second_);
+		history_.Erase(found);
+		retainedTitles_.Erase(title);
+	}
+
+	void DevServer::RetireHistory(Vector<HistoryFrame>& frames)
+	{
+		// the last reference must go on the main thread, a frame a request holds waits in retiredHistory_
+		for (auto& frame : frames)
+		{
+			if (frame.image_.use_count() > 1)
+				retiredHistory_.Push(frame.image_);
+		}
+		frames.Clear();
+	}
+
+	Vector<Pair<unsigned, String> > DevServer::GetPublishHistory(const String& title) const
+	{
+		Vector<Pair<unsigned, String> > ret;
+		MutexLock lock(historyMutex_);
+		auto found = history_.Find(title);
+		if (found == history_.End())
+			return ret;
+		for (unsigned i = 0; i < found->second_.Size(); ++i)
+		{
+			// pending frames can't be fetched yet, the latest is served as the page's own image
+			const HistoryFrame& frame = found->second_[i];
+			if (!frame.pending_ || i + 1 == found->second_.Size())
+				ret.Push(MakePair(frame.version_, frame.timeStamp_));
+		}
+		return ret;
+	}
+
+	std::shared_ptr<Image> DevServer::AcquireHistoryFrame(const String& title, unsigned version)
+	{
+		MutexLock lock(historyMutex_);
+		auto found = history_.Find(title);
+		if (found == history_.End())
+			return nullptr;
+		for (auto& frame : found->second_)
+		{
+			if (frame.version_ != version)
+				continue;
+			// a pending frame may still be copied on the main thread
+			if (frame.pending_)
+				return nullptr;
+			frame.lastUsed_ = ++historyTick_;
+			return frame.image_;
+		}
+		return nullptr;
 	}
 
-	void DevServer::Publish(const String& title, const SharedPtr<Image>& content)
+	void DevServer::BroadcastPage(const String& title, const StaticItem& item)
 	{
-		StaticItem item;
-		item.image_ = content;
-		item.timeStamp_ = Time::GetTimeStamp();
+		if (!streamHub_.HasClients(STREAM_PAGES))
+			return;
 
-		simpleTexts_.Insert(Pair<String, StaticItem>(title, item));
+		// images are left for the client to fetch, text goes inline
+		DevServerJSONWriter writer(item.text_.Length() + 128);
+		writer.BeginObject();
+		writer.Key("title");
+		writer.Value(title);
+		writer.Key("version");
+		writer.Value(item.version_);
+		writer.Key("time");
+		writer.Value(item.timeStamp_);
+		writer.Key("url");
+		writer.Value("/Pages/" + URLEncodePath(title, false));
+		if (item.image_)
+		{
+			writer.Key("image");
+			writer.Value(true);
+		}
+		else
+		{
+			writer.Key("text");
+			writer.Value(item.text_);
+		}
+		writer.EndObject();
+		streamHub_.Broadcast(STREAM_PAGES, "page", writer.GetBuffer(), item.version_);
 	}
 
 	void DevServer::AddStaticLink(const String& title, const String& url)
 	{
 		staticLinks_.Push(Pair<String, String>(title, url));
+		snapshotDirty_ = true;
+		navigationDirty_ = true;
 	}
 
 	void DevServer::RegisterCommand(const String& name, const String& tip, std::function<void(Context*)> cmd)
@@ -509,6 +1868,14 @@ namespace Urho3D
 		item.url_.Replace(' ', '_');
 		item.command_ = cmd;
 		commands_.push_back(item);
+		snapshotDirty_ = true;
+		navigationDirty_ = true;
+	}
+
+	void DevServer::SimpleHandler::RegisterRoutes(DevServerRouter& router)
+	{
+		// a tail capture, so titles containing a slash still reach the page
+		router.Get("Pages/{*page}", this);
 	}
 
 	bool DevServer::SimpleHandler::Handles(DevServer* server, const Vector<String>& uri)
@@ -517,48 +1884,179 @@ namespace Urho3D
 			return false;
 		if (uri[0].Compare("Pages", false) != 0)
 			return false;
-		auto found = server->simpleTexts_.Find(uri[1]);
-		if (found != server->simpleTexts_.End())
-			return true;
-		return false;
+		return server->AcquireSnapshot()->FindPage(uri[1]) != nullptr;
 	}
 
-	String DevServer::SimpleHandler::EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params)
+	/// Script that reloads a published page once a newer version of it is announced on /Stream/Pages.
+	static String PageReloadScript(const String& title, unsigned version)
 	{
-		auto found = server->simpleTexts_.Find(uri[1]);
+		DevServerJSONWriter titleJSON;
+		titleJSON.Value(title);
+
 		String ret;
-		ret += "<h2>" + found->second_.timeStamp_ + "</h2>\r\n";
-		if (auto img = found->second_.image_)
+		ret += "<script>";
+		ret += "if (window.EventSource) {";
+		ret += "  var pageTitle = " + titleJSON.GetBuffer().Replaced("</", "<\\/") + ";";
+		ret += ToString("  var pageVersion = %u;", version);
+		ret += "  new EventSource('/Stream/Pages').addEventListener('page', function(msg) {";
+		ret += "    var page = JSON.parse(msg.data);";
+		ret += "    if (page.title == pageTitle && page.version > pageVersion) window.location.reload();";
+		ret += "  });";
+		ret += "}";
+		ret += "</script>";
+		return ret;
+	}
+
+	/// Slider stepping the page's image through its publish history, empty when there's nothing to step through.
+	static String HistoryScrubber(const Vector<Pair<unsigned, String> >& frames, const String& title)
+	{
+		if (frames.Size() < 2)
+			return String();
+
+		DevServerJSONWriter writer(frames.Size() * 40 + title.Length() + 16);
+		writer.BeginObject();
+		writer.Key("title");
+		writer.Value(title);
+		writer.Key("frames");
+		writer.BeginArray();
+		for (const auto& frame : frames)
 		{
-			ret += "<image src=\"data:image/png;base64, ";
+			writer.BeginArray();
+			writer.Value(frame.first_);
+			writer.Value(frame.second_);
+			writer.EndArray();
+		}
+		writer.EndArray();
+		writer.EndObject();
 
-			VectorBuffer buffer;
-			int len;
-			unsigned char* png = stbi_write_png_to_mem(img->GetData(), 0, img->GetWidth(), img->GetHeight(), img->GetComponents(), &len);
-			bool success = buffer.Write(png, (unsigned)len) == (unsigned)len;
-			free(png);
-			
-			auto b64Size = Base64::EncodedLength(buffer.GetSize());
-			char* data = new char[b64Size];
-			if (Base64::Encode((const char*)buffer.GetData(), buffer.GetSize(), data, b64Size))
-				ret += String(data, b64Size);
-			delete[] data;
+		String ret;
+		ret += "<div class=\"form-inline\" style=\"margin-bottom:10px\">";
+		ret += "<button type=\"button\" class=\"btn btn-default\" id=\"historyPrev\">&lt;</button> ";
+		ret += ToString("<input type=\"range\" id=\"historySlider\" min=\"0\" max=\"%u\" value=\"%u\" style=\"display:inline-block;width:60%%;vertical-align:middle\" /> ", frames.Size() - 1, frames.Size() - 1);
+		ret += "<button type=\"button\" class=\"btn btn-default\" id=\"historyNext\">&gt;</button> ";
+		ret += "<span id=\"historyLabel\"></span>";
+		ret += "</div>";
+		ret += "<script>";
+		ret += "(function() {";
+		ret += "  var published = " + writer.GetBuffer().Replaced("</", "<\\/") + ";";
+		ret += "  var slider = document.getElementById('historySlider');";
+		ret += "  var label = document.getElementById('historyLabel');";
+		ret += "  var base = '/Pages/' + encodeURIComponent(published.title) + '.png';";
+		ret += "  function show(i) {";
+		ret += "    i = Math.max(0, Math.min(published.frames.length - 1, i));";
+		ret += "    slider.value = i;";
+		ret += "    var frame = published.frames[i];";
+		// the latest frame has its own cached URL, older ones are picked out of the history
+		ret += "    document.getElementById('pageImage').src = base + (i == published.frames.length - 1 ? '?v=' : '?frame=') + frame[0];";
+		ret += "    document.getElementById('pageTime').textContent = frame[1];";
+		ret += "    label.textContent = (i + 1) + ' / ' + published.frames.length;";
+		ret += "  }";
+		ret += "  slider.addEventListener('input', function() { show(+slider.value); });";
+		ret += "  document.getElementById('historyPrev').addEventListener('click', function() { show(+slider.value - 1); });";
+		ret += "  document.getElementById('historyNext').addEventListener('click', function() { show(+slider.value + 1); });";
+		ret += "  document.addEventListener('keydown', function(e) {";
+		ret += "    if (e.keyCode == 37) show(+slider.value - 1);";
+		ret += "    else if (e.keyCode == 39) show(+slider.value + 1);";
+		ret += "  });";
+		ret += "  document.addEventListener('DOMContentLoaded', function() { show(published.frames.length - 1); });";
+		ret += "})();";
+		ret += "</script>";
+		return ret;
+	}
+
+	String DevServer::SimpleHandler::EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params)
+	{
+		auto snapshot = server->AcquireSnapshot();
+		const String title = GetURIParam(params, "page");
+		const StaticItem* item = snapshot->FindPage(title);
+		if (!item)
+		{
+			return server->FillTemplate("template_page.html", {
+					{ "${TITLE}", "Diagnostics" },
+					{ "${BODY}", "<div class=\"well\">Nothing has been published under that name</div>" }
+				});
+		}
 
-			ret += "\" />";
+		String ret;
+		ret += "<h2 id=\"pageTime\">" + item->timeStamp_ + "</h2>\r\n";
+		if (item->image_)
+		{
+			ret += HistoryScrubber(server->GetPublishHistory(title), title);
+			// the PNG is its own cached resource, the version keeps the browser from showing a stale copy
+			ret += ToString("<img id=\"pageImage\" src=\"/Pages/%s.png?v=%u\" />", URLEncodePath(title, false).CString(), item->version_);
 		}
 		else
 		{
 			ret += "<pre>\r\n";
-			ret += found->second_.text_;
+			ret += item->text_;
 			ret += "\r\n</pre>";
 		}
+		ret += PageReloadScript(title, item->version_);
 
 		return server->FillTemplate("template_page.html", { 
-				{ "${TITLE}", found->first_ }, 
+				{ "${TITLE}", title }, 
 				{ "${BODY}", ret } 
 			});
 	}
 
+	bool DevServer::SimpleHandler::Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response)
+	{
+		// held until the image is sent, the snapshot keeps it alive
+		auto snapshot = server->AcquireSnapshot();
+		const String page = GetURIParam(params, "page");
+		if (snapshot->FindPage(page))
+			return DevServerHandler::Emit(server, uri, params, response);
+
+		String title;
+		const StaticItem* item = snapshot->FindImage(page, title);
+		if (!item)
+			return DevServerHandler::Emit(server, uri, params, response);
+
+		// ?frame= picks an earlier version from the publish history
+		Image* image = item->image_;
+		unsigned version = item->version_;
+		std::shared_ptr<Image> frame;
+		if (params.Contains("frame"))
+		{
+			version = ToUInt(GetURIParam(params, "frame"));
+			frame = server->AcquireHistoryFrame(title, version);
+			if (!frame)
+				return false;
+			image = frame.get();
+		}
+
+		// only the default encoding is cached, anything else is encoded per request
+		if (params.Contains("fmt") || params.Contains("level"))
+			return SendImage(response, image, params);
+
+		EncodedImage png = server->GetPublishedPNG(title, version, image);
+		if (!png)
+			return false;
+		response.SetContentType("image/png");
+		response.SetContentLength(png->Size());
+		response.Write(png->Buffer(), png->Size());
+		return true;
+	}
+
+	String DevServer::SimpleHandler::GetETag(DevServer* server, const Vector<String>& uri, const VariantMap& params)
+	{
+		auto snapshot = server->AcquireSnapshot();
+		const String page = GetURIParam(params, "page");
+		const StaticItem* item = snapshot->FindPage(page);
+		if (!item)
+		{
+			// the image alone doesn't include the menu
+			String title;
+			item = snapshot->FindImage(page, title);
+			if (!item)
+				return String();
+			// a version's pixels never change, so the history frame asked for is its own tag
+			const unsigned version = params.Contains("frame") ? ToUInt(GetURIParam(params, "frame")) : item->version_;
+			return ToString("i%u", version) + GetImageETagSuffix(params);
+		}
+		return ToString("p%u-n%u", item->version_, server->GetNavigationGeneration());
+	}
+
 	void DevServer::SimpleHandler::WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI)
 	{
 		
@@ -566,18 +2064,83 @@ namespace Urho3D
 
 	void DevServer::SimpleHandler::WriteRawNavigation(DevServer* server, String& data) 
 	{
-		if (server->simpleTexts_.Empty())
+		auto snapshot = server->AcquireSnapshot();
+		if (snapshot->pages_.Empty())
 			return;
 
 		data += "<li class=\"nav-item dropdown\">";
 		data += "<a class=\"nav-link dropdown-toggle\" href=\"#\" id=\"navbarDropdown\" role=\"button\" data-toggle=\"dropdown\" aria-haspopup=\"true\" aria-expanded=\"false\">Diagnostics</a>";
 		data += "<div class=\"dropdown-menu\" aria-labelledby=\"navbarDropdown\">";
-		for (auto entry : server->simpleTexts_)
-			data += "<a class=\"dropdown-item\" href=\"Pages/" + entry.first_ + "\">" + entry.first_ + "</a>";
+		for (const auto& entry : snapshot->pages_)
+			data += "<a class=\"dropdown-item\" href=\"/Pages/" + URLEncodePath(entry.first_, false) + "\">" + EscapeHTML(entry.first_) + "</a>";
 		data += "</div>";
 		data += "</li>";
 	}
 
+	void DevServer::StreamHandler::RegisterRoutes(DevServerRouter& router)
+	{
+		router.Get("Stream/{channel}", this);
+	}
+
+	bool DevServer::StreamHandler::Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response)
+	{
+		String channel = GetURIParam(params, "channel");
+		if (channel.Compare(STREAM_LOG, false) == 0)
+			channel = STREAM_LOG;
+		else if (channel.Compare(STREAM_PAGES, false) == 0)
+			channel = STREAM_PAGES;
+
+		auto client = server->streamHub_.Subscribe(channel);
+		if (!client)
+			return false;
+
+		// events must reach the browser as they're written, never held back for compression
+		response.EnableCompression(DSE_IDENTITY, 0, 0);
+		response.SetContentType("text/event-stream");
+		response.AddHeader("Cache-Control", "no-cache");
+		response += "retry: 2000\n\n";
+
+		// a reconnecting EventSource reports what it last saw, otherwise the page passes its cursor
+		if (channel == STREAM_LOG)
+		{
+			const char* lastEventId = response.GetRequestHeader("Last-Event-ID");
+			const String since = lastEventId ? String(lastEventId) : GetURIParam(params, "since");
+			if (!since.Empty())
+			{
+				Vector<DevServerLogEntry> entries;
+				const int minLevel = ToInt(GetURIParam(params, "level", "0"));
+				const unsigned long long cursor = server->logRing_.ReadSince(strtoull(since.CString(), nullptr, 10), minLevel, 0, entries);
+				client->SkipThrough(cursor);
+				for (const auto& entry : entries)
+					response += DevServerStreamHub::FormatEvent("log", LogEntryToJSON(entry), entry.sequence_);
+			}
+		}
+		response.Flush();
+
+		Vector<DevServerStreamClient::Frame> frames;
+		unsigned dropped = 0;
+		while (!response.HasFailed() && client->Wait(frames, dropped, STREAM_KEEPALIVE_MS))
+		{
+			if (dropped)
+				response += DevServerStreamHub::FormatEvent("dropped", String(dropped));
+			for (const auto& frame : frames)
+				response += *frame;
+			if (frames.Empty() && !dropped)
+				response += ": keepalive\n\n";
+			frames.Clear();
+			response.Flush();
+		}
+
+		server->streamHub_.Unsubscribe(client);
+		return true;
+	}
+
+	void DevServer::CommandHandler::RegisterRoutes(DevServerRouter& router)
+	{
+		router.Get("Commands", this);
+		router.Post("Commands/{command}", this);
+	}
+
 	bool DevServer::CommandHandler::Handles(DevServer*, const Vector<String>& uri)
 	{
 		return uri.Size() > 0 && uri[0].Compare("Commands", false) == 0;
@@ -586,7 +2149,8 @@ namespace Urho3D
 	{
 		if (uri.Size() < 2)
 			return false;
-		for (auto com : server->commands_)
+		auto snapshot = server->AcquireSnapshot();
+		for (const auto& com : snapshot->commands_)
 		{
 			// already passed, don't worry about checking uri 0
 			if (com.url_.Compare(uri[1], false) == 0)
@@ -597,7 +2161,8 @@ namespace Urho3D
 	String DevServer::CommandHandler::EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params)
 	{
 		String html;
-		for (auto com : server->commands_)
+		auto snapshot = server->AcquireSnapshot();
+		for (const auto& com : snapshot->commands_)
 		{
 			html += "<button type=\"button\" class=\"btn btn-info\" onclick=\"$.post('Commands/" + com.url_ + "');\" style=\"margin: 10px\">" + com.title_ + "</button>";
 			if (!com.tip_.Empty())
@@ -612,24 +2177,709 @@ namespace Urho3D
 	}
 	void DevServer::CommandHandler::DoPost(DevServer* server, const Vector<String>& uri, const String& postData)
 	{
-		for (auto com : server->commands_)
-		{
-			if (com.url_.Compare(uri[1], false) == 0)
+		if (uri.Size() < 2)
+			return;
+
+		// the command is looked up again on the main thread, its function (and whatever it captured) never leaves it
+		const String url = uri[1];
+		server->AddDeferredCommand([server, url]() {
+			for (const auto& com : server->commands_)
 			{
-				server->AddDeferredCommand([=]() {
+				if (com.url_.Compare(url, false) == 0)
+				{
 					com.command_(server->GetContext());
-				});
-				return;
+					return;
+				}
 			}
-		}
+		});
 	}
 
 	void DevServer::CommandHandler::WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI)
 	{ 
-		if (server->commands_.size() > 0)
+		if (!server->AcquireSnapshot()->commands_.empty())
 			titleAndURI.Push(Pair<String, String>("Commands", "/Commands"));
 	}
 
+	void DevServer::CompressionHandler::RegisterRoutes(DevServerRouter& router)
+	{
+		router.Get("DevServer/Compression", this);
+	}
+
+	String DevServer::CompressionHandler::EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params)
+	{
+		String html;
+		html += "<table class=\"table table-sm\">";
+		html += "<tr><th scope=\"col\">Endpoint</th><th scope=\"col\">Responses</th><th scope=\"col\">Generated</th><th scope=\"col\">Sent</th><th scope=\"col\">Ratio</th><th scope=\"col\">Compression CPU</th><th scope=\"col\">Per response</th></tr>";
+		auto stats = server->GetCompressionStats();
+		for (auto entry : stats)
+		{
+			const auto& s = entry.second_;
+			const float ratio = s.rawBytes_ > 0 ? (float)((double)s.sentBytes_ / (double)s.rawBytes_) : 1.0f;
+			html += "<tr><td>" + entry.first_ + "</td>";
+			html += "<td>" + String(s.responses_) + "</td>";
+			html += "<td>" + GetFileSizeString(s.rawBytes_) + "</td>";
+			html += "<td>" + GetFileSizeString(s.sentBytes_) + "</td>";
+			html += "<td>" + ToString("%.1f%%", ratio * 100.0f) + "</td>";
+			html += "<td>" + ToString("%.2f ms", s.usec_ / 1000.0f) + "</td>";
+			html += "<td>" + ToString("%.1f us", s.responses_ > 0 ? (float)s.usec_ / s.responses_ : 0.0f) + "</td></tr>";
+		}
+		html += "</table>";
+
+		return server->FillTemplate("template_page.html", {
+			{ "${TITLE}", "Compression" },
+			{ "${BODY}", html }
+			});
+	}
+
+	void DevServer::StatsHandler::RegisterRoutes(DevServerRouter& router)
+	{
+		router.Get("DevServer/Stats", this);
+	}
+
+	/// A duration for the stats tables, microseconds below a millisecond.
+	static String FormatLatency(unsigned usec)
+	{
+		return usec < 1000 ? ToString("%u us", usec) : ToString("%.2f ms", usec / 1000.0f);
+	}
+
+	/// Summary of a histogram as {count, total, mean, p50, p90, p99, p999, max}, durations in microseconds.
+	static void WriteHistogramJSON(DevServerJSONWriter& writer, const char* key, const DevLatencyHistogram& histogram)
+	{
+		writer.Key(key);
+		writer.BeginObject();
+		writer.Key("count");
+		writer.Value(histogram.GetCount());
+		writer.Key("total");
+		writer.Value(histogram.GetTotal());
+		writer.Key("mean");
+		writer.Value(histogram.GetMean());
+		writer.Key("p50");
+		writer.Value(histogram.GetPercentile(0.5f));
+		writer.Key("p90");
+		writer.Value(histogram.GetPercentile(0.9f));
+		writer.Key("p99");
+		writer.Value(histogram.GetPercentile(0.99f));
+		writer.Key("p999");
+		writer.Value(histogram.GetPercentile(0.999f));
+		writer.Key("max");
+		writer.Value(histogram.GetMax());
+		writer.EndObject();
+	}
+
+	bool DevServer::StatsHandler::Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response)
+	{
+		if (GetURIParam(params, "format").Compare("json", false) != 0)
+			return DevServerHandler::Emit(server, uri, params, response);
+
+		const DevServerStats& stats = server->GetStats();
+		Vector<Pair<String, const DevEndpointStats*> > endpoints;
+		stats.GetEndpoints(endpoints);
+
+		DevServerJSONWriter writer;
+		writer.BeginObject();
+		writer.Key("elapsed");
+		writer.Value(stats.GetElapsedTime());
+		writer.Key("mainThread");
+		writer.BeginObject();
+		writer.Key("share");
+		writer.Value(stats.GetMainThreadShare());
+		WriteHistogramJSON(writer, "frame", stats.GetFrameCost());
+		WriteHistogramJSON(writer, "log", stats.GetLogCost());
+		writer.EndObject();
+
+		const DevServerCommandQueue& commands = server->GetCommandQueue();
+		writer.Key("commands");
+		writer.BeginObject();
+		writer.Key("budget");
+		writer.Value(server->GetCommandBudget());
+		writer.Key("depth");
+		writer.Value(commands.GetDepth());
+		writer.Key("maxDepth");
+		writer.Value(commands.GetMaxDepth());
+		writer.Key("executed");
+		writer.Value(commands.GetExecuted());
+		writer.Key("carriedFrames");
+		writer.Value(commands.GetCarriedFrames());
+		WriteHistogramJSON(writer, "latency", commands.GetLatency());
+		WriteHistogramJSON(writer, "run", commands.GetRunTime());
+		writer.EndObject();
+		writer.Key("endpoints");
+		writer.BeginObject();
+		for (const auto& endpoint : endpoints)
+		{
+			const DevEndpointStats& e = *endpoint.second_;
+			writer.Key(endpoint.first_);
+			writer.BeginObject();
+			writer.Key("bytes");
+			writer.Value(e.bytes_.load(std::memory_order_relaxed));
+			writer.Key("notModified");
+			writer.Value(e.notModified_.load(std::memory_order_relaxed));
+			WriteHistogramJSON(writer, "total", e.total_);
+			WriteHistogramJSON(writer, "match", e.match_);
+			WriteHistogramJSON(writer, "emit", e.emit_);
+			WriteHistogramJSON(writer, "write", e.write_);
+			writer.EndObject();
+		}
+		writer.EndObject();
+		writer.EndObject();
+
+		response.SetContentType("application/json");
+		response.AddHeader("Cache-Control", "no-cache");
+		response += writer.GetBuffer();
+		return true;
+	}
+
+	String DevServer::StatsHandler::EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params)
+	{
+		const DevServerStats& stats = server->GetStats();
+		String html;
+
+		html += "<h5>Main thread</h5>";
+		html += ToString("<p>%.3f%% of the last %.1f s spent in DevServer.</p>", stats.GetMainThreadShare() * 100.0f, stats.GetElapsedTime() / 1000.0f);
+		html += "<table class=\"table table-sm\">";
+		html += "<tr><th scope=\"col\">Work</th><th scope=\"col\">Calls</th><th scope=\"col\">Mean</th><th scope=\"col\">p50</th><th scope=\"col\">p99</th><th scope=\"col\">Max</th><th scope=\"col\">Total</th></tr>";
+		const DevServerCommandQueue& commands = server->GetCommandQueue();
+		const Pair<const char*, const DevLatencyHistogram*> work[] = {
+			MakePair("OnNewFrame", &stats.GetFrameCost()),
+			MakePair("OnLog", &stats.GetLogCost()),
+			MakePair("Queued commands (in OnNewFrame)", &commands.GetRunTime()),
+		};
+		for (const auto& item : work)
+		{
+			const DevLatencyHistogram& h = *item.second_;
+			html += "<tr><td>" + String(item.first_) + "</td>";
+			html += "<td>" + String((unsigned)h.GetCount()) + "</td>";
+			html += "<td>" + ToString("%.1f us", h.GetMean()) + "</td>";
+			html += "<td>" + FormatLatency(h.GetPercentile(0.5f)) + "</td>";
+			html += "<td>" + FormatLatency(h.GetPercentile(0.99f)) + "</td>";
+			html += "<td>" + FormatLatency(h.GetMax()) + "</td>";
+			html += "<td>" + ToString("%.2f ms", h.GetTotal() / 1000.0f) + "</td></tr>";
+		}
+		html += "</table>";
+		html += ToString("<p>Command queue: %u waiting (at most %u), %llu run, %llu frames over the %u us budget, queued for p50 %s / p99 %s.</p>",
+			commands.GetDepth(), commands.GetMaxDepth(), commands.GetExecuted(), commands.GetCarriedFrames(), server->GetCommandBudget(),
+			FormatLatency(commands.GetLatency().GetPercentile(0.5f)).CString(), FormatLatency(commands.GetLatency().GetPercentile(0.99f)).CString());
+
+		// match, emit and write are p99s, they don't add up to the total's
+		html += "<h5>Requests</h5>";
+		html += "<table class=\"table table-sm\">";
+		html += "<tr><th scope=\"col\">Endpoint</th><th scope=\"col\">Requests</th><th scope=\"col\">304</th><th scope=\"col\">p50</th><th scope=\"col\">p90</th><th scope=\"col\">p99</th><th scope=\"col\">Max</th>"
+			"<th scope=\"col\">Match p99</th><th scope=\"col\">Emit p99</th><th scope=\"col\">Write p99</th><th scope=\"col\">Sent</th></tr>";
+		Vector<Pair<String, const DevEndpointStats*> > endpoints;
+		stats.GetEndpoints(endpoints);
+		for (const auto& endpoint : endpoints)
+		{
+			const DevEndpointStats& e = *endpoint.second_;
+			html += "<tr><td>" + EscapeHTML(endpoint.first_) + "</td>";
+			html += "<td>" + String((unsigned)e.total_.GetCount()) + "</td>";
+			html += "<td>" + String((unsigned)e.notModified_.load(std::memory_order_relaxed)) + "</td>";
+			html += "<td>" + FormatLatency(e.total_.GetPercentile(0.5f)) + "</td>";
+			html += "<td>" + FormatLatency(e.total_.GetPercentile(0.9f)) + "</td>";
+			html += "<td>" + FormatLatency(e.total_.GetPercentile(0.99f)) + "</td>";
+			html += "<td>" + FormatLatency(e.total_.GetMax()) + "</td>";
+			html += "<td>" + FormatLatency(e.match_.GetPercentile(0.99f)) + "</td>";
+			html += "<td>" + FormatLatency(e.emit_.GetPercentile(0.99f)) + "</td>";
+			html += "<td>" + FormatLatency(e.write_.GetPercentile(0.99f)) + "</td>";
+			html += "<td>" + GetFileSizeString(e.bytes_.load(std::memory_order_relaxed)) + "</td></tr>";
+		}
+		html += "</table>";
+		html += "<p><a href=\"/DevServer/Stats?format=json\">JSON</a> &middot; <a href=\"/DevServer/Compression\">Compression</a></p>";
+
+		return server->FillTemplate("template_page.html", {
+			{ "${TITLE}", "DevServer Stats" },
+			{ "${BODY}", html }
+			});
+	}
+
+	/// Most results /Search shows, handlers add up to a hundred per term and scene.
+	static const unsigned SEARCH_MAX_RESULTS = 500;
+
+	/// Splits ?q= into terms and asks every handler, duplicates from overlapping terms are dropped.
+	/// Returns whether there were more than SEARCH_MAX_RESULTS results and some were left out.
+	static bool CollectSearchResults(DevServer* server, const Vector<DevServerHandler*>& handlers, const VariantMap& params, Vector<Pair<String, String> >& results)
+	{
+		const StringVector terms = GetURIParam(params, "q").Split(' ');
+		if (terms.Empty())
+			return false;
+
+		Vector<Pair<String, String> > found;
+		for (auto handler : handlers)
+			handler->Search(server, terms, found);
+
+		HashSet<String> seen;
+		for (const auto& result : found)
+		{
+			// one past the limit tells a full page from a cut-off one
+			if (results.Size() > SEARCH_MAX_RESULTS)
+				break;
+			const String key = result.second_ + "\n" + result.first_;
+			if (seen.Contains(key))
+				continue;
+			seen.Insert(key);
+			results.Push(result);
+		}
+
+		if (results.Size() <= SEARCH_MAX_RESULTS)
+			return false;
+		results.Pop();
+		return true;
+	}
+
+	void DevServer::SearchHandler::RegisterRoutes(DevServerRouter& router)
+	{
+		router.Get("Search", this);
+	}
+
+	bool DevServer::SearchHandler::Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response)
+	{
+		if (GetURIParam(params, "format").Compare("json", false) != 0)
+			return DevServerHandler::Emit(server, uri, params, response);
+
+		Vector<Pair<String, String> > results;
+		const bool truncated = CollectSearchResults(server, server->handlers_, params, results);
+
+		DevServerJSONWriter writer(results.Size() * 96 + 64);
+		writer.BeginObject();
+		writer.Key("query");
+		writer.Value(GetURIParam(params, "q"));
+		writer.Key("results");
+		writer.BeginArray();
+		for (const auto& result : results)
+		{
+			writer.BeginObject();
+			writer.Key("title");
+			writer.Value(result.first_);
+			writer.Key("url");
+			writer.Value(result.second_);
+			writer.EndObject();
+		}
+		writer.EndArray();
+		writer.Key("truncated");
+		writer.Value(truncated);
+		writer.EndObject();
+
+		response.SetContentType("application/json");
+		response.AddHeader("Cache-Control", "no-cache");
+		response += writer.GetBuffer();
+		return true;
+	}
+
+	String DevServer::SearchHandler::EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params)
+	{
+		const String query = GetURIParam(params, "q");
+		Vector<Pair<String, String> > results;
+		const bool truncated = CollectSearchResults(server, server->handlers_, params, results);
+
+		String html;
+		html += "<form class=\"form-inline mb-3\" action=\"/Search\" method=\"get\">";
+		html += "<input id=\"searchQuery\" class=\"form-control mr-2\" type=\"search\" name=\"q\" placeholder=\"Name, tag, variable or component\" autocomplete=\"off\" value=\"" + EscapeHTML(query) + "\">";
+		html += "<button class=\"btn btn-primary\" type=\"submit\">Search</button>";
+		html += "</form>";
+		html += "<p class=\"text-muted\">Terms are separated by spaces and match anywhere in a name once they're three characters long, end one with * to only match the start.</p>";
+		html += "<ul id=\"searchResults\">";
+		for (const auto& result : results)
+			html += "<li><a href=\"" + EscapeHTML(result.second_) + "\">" + EscapeHTML(result.first_) + "</a></li>";
+		if (!query.Trimmed().Empty() && results.Empty())
+			html += "<li class=\"text-muted\">Nothing found</li>";
+		if (truncated)
+			html += ToString("<li class=\"text-muted\">Showing the first %u, add terms to narrow it down</li>", results.Size());
+		html += "</ul>";
+		html += "<script src=\"/js/search.js\"></script>";
+
+		return server->FillTemplate("template_page.html", {
+			{ "${TITLE}", "Search" },
+			{ "${BODY}", html }
+			});
+	}
+
+	void DevServer::SearchHandler::WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI)
+	{
+		titleAndURI.Push(Pair<String, String>("Search", "/Search"));
+	}
+
+	/// Window a /Metrics/Samples request covers when none is asked for.
+	static const unsigned METRICS_DEFAULT_WINDOW_MS = 60000;
+
+	static const char* GetMetricKindName(DevMetricKind kind)
+	{
+		return kind == DMK_COUNTER ? "counter" : "value";
+	}
+
+	void DevServer::MetricsHandler::RegisterRoutes(DevServerRouter& router)
+	{
+		router.Get("Metrics", this);
+		router.Get("Metrics/Channels", this);
+		router.Get("Metrics/Samples/{*channel}", this);
+	}
+
+	String DevServer::MetricsHandler::EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params)
+	{
+		String html;
+		html += "<div class=\"form-inline mb-3\"><label for=\"metricsWindow\" class=\"mr-2\">Window</label>";
+		html += "<select id=\"metricsWindow\" class=\"form-control form-control-sm\">";
+		html += "<option value=\"10000\">10 seconds</option>";
+		html += ToString("<option value=\"%u\" selected>1 minute</option>", METRICS_DEFAULT_WINDOW_MS);
+		html += "<option value=\"300000\">5 minutes</option>";
+		html += "<option value=\"1800000\">30 minutes</option>";
+		html += "</select></div>";
+		html += "<div id=\"metricsEmpty\" class=\"well\">Nothing has been published with PublishValue or PublishCounter yet</div>";
+		html += ToString("<div id=\"metrics\" data-window=\"%u\"></div>", METRICS_DEFAULT_WINDOW_MS);
+		html += "<script src=\"/js/metrics.js\"></script>";
+
+		return server->FillTemplate("template_page.html", {
+			{ "${TITLE}", "Metrics" },
+			{ "${BODY}", html }
+			});
+	}
+
+	bool DevServer::MetricsHandler::Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response)
+	{
+		if (uri.Size() < 2)
+			return DevServerHandler::Emit(server, uri, params, response);
+
+		const DevServerMetrics& metrics = server->metrics_;
+		DevServerJSONWriter writer;
+		if (uri[1].Compare("Channels", false) == 0)
+		{
+			// channels are [{name, kind, last}], last being the newest sample's sequence
+			const unsigned count = metrics.GetNumChannels();
+			writer.BeginObject();
+			writer.Key("frame");
+			writer.Value(metrics.GetFrame());
+			writer.Key("channels");
+			writer.BeginArray();
+			for (unsigned i = 0; i < count; ++i)
+			{
+				writer.BeginObject();
+				writer.Key("name");
+				writer.Value(metrics.GetChannelName(i));
+				writer.Key("kind");
+				writer.Value(GetMetricKindName(metrics.GetChannelKind(i)));
+				writer.Key("last");
+				writer.Value(metrics.GetLastSequence(i));
+				writer.EndObject();
+			}
+			writer.EndArray();
+			writer.EndObject();
+		}
+		else
+		{
+			const int channel = metrics.FindChannel(GetURIParam(params, "channel"));
+			if (channel < 0)
+				return false;
+
+			const unsigned long long since = strtoull(GetURIParam(params, "since").CString(), nullptr, 10);
+			const unsigned windowMs = ToUInt(GetURIParam(params, "window", String(METRICS_DEFAULT_WINDOW_MS)));
+			const unsigned points = ToUInt(GetURIParam(params, "points"));
+			PODVector<DevMetricSample> samples;
+			const unsigned long long next = metrics.ReadSince((unsigned)channel, since, windowMs, samples);
+
+			writer.BeginObject();
+			writer.Key("name");
+			writer.Value(metrics.GetChannelName((unsigned)channel));
+			writer.Key("kind");
+			writer.Value(GetMetricKindName(metrics.GetChannelKind((unsigned)channel)));
+			writer.Key("now");
+			writer.Value(metrics.GetTime());
+			writer.Key("next");
+			writer.Value(next);
+			if (points && samples.Size() > points)
+			{
+				// buckets are [time, min, max, avg, count]
+				PODVector<DevMetricBucket> buckets;
+				DevServerMetrics::Decimate(samples, points, buckets);
+				writer.Key("buckets");
+				writer.BeginArray();
+				for (const auto& bucket : buckets)
+				{
+					writer.BeginArray();
+					writer.Value(bucket.time_);
+					writer.Value(bucket.min_);
+					writer.Value(bucket.max_);
+					writer.Value(bucket.avg_);
+					writer.Value(bucket.count_);
+					writer.EndArray();
+				}
+				writer.EndArray();
+			}
+			else
+			{
+				// samples are [sequence, frame, time, value]
+				writer.Key("samples");
+				writer.BeginArray();
+				for (const auto& sample : samples)
+				{
+					writer.BeginArray();
+					writer.Value(sample.sequence_);
+					writer.Value(sample.frame_);
+					writer.Value(sample.time_);
+					writer.Value(sample.value_);
+					writer.EndArray();
+				}
+				writer.EndArray();
+			}
+			writer.EndObject();
+		}
+
+		response.SetContentType("application/json");
+		response.AddHeader("Cache-Control", "no-cache");
+		response += writer.GetBuffer();
+		return true;
+	}
+
+	void DevServer::MetricsHandler::WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI)
+	{
+		titleAndURI.Push(Pair<String, String>("Metrics", "/Metrics"));
+	}
+
+	/// Frame time a /Profiler view marks frames over when none is asked for, in milliseconds.
+	static const float PROFILER_DEFAULT_THRESHOLD_MS = 16.7f;
+
+	void DevServer::ProfilerHandler::RegisterRoutes(DevServerRouter& router)
+	{
+		router.Get("Profiler", this);
+		router.Get("Profiler/Frames", this);
+		router.Get("Profiler/Blocks", this);
+		router.Get("Profiler/Frame/{sequence}", this);
+	}
+
+	String DevServer::ProfilerHandler::EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params)
+	{
+		String html;
+		if (!server->GetSubsystem<Profiler>())
+			html += "<div class=\"well\">The engine was built without URHO3D_PROFILING, there is no Profiler to capture</div>";
+
+		const float threshold = params.Contains("threshold") ? ToFloat(GetURIParam(params, "threshold")) : PROFILER_DEFAULT_THRESHOLD_MS;
+		html += "<div class=\"form-inline mb-2\">";
+		html += ToString("<label for=\"profilerThreshold\" class=\"mr-2\">Mark frames over</label><input id=\"profilerThreshold\" type=\"number\" step=\"0.1\" min=\"0\" value=\"%.1f\" class=\"form-control form-control-sm mr-2\" style=\"width:6em\" /> ms", threshold);
+		html += "<div class=\"form-check ml-3\"><input id=\"profilerPause\" type=\"checkbox\" class=\"form-check-input\" /><label for=\"profilerPause\" class=\"form-check-label\">Pause</label></div>";
+		html += "<span id=\"profilerCapture\" class=\"ml-auto text-muted small\"></span>";
+		html += "</div>";
+		html += "<canvas id=\"profilerFrames\" height=\"100\" style=\"width:100%;height:100px;cursor:pointer\"></canvas>";
+		html += "<h5 class=\"mt-3\" id=\"profilerFrameTitle\">Click a frame to see its blocks</h5>";
+		html += "<canvas id=\"profilerFlame\" height=\"0\" style=\"width:100%\"></canvas>";
+		html += "<h5 class=\"mt-3\">Blocks over the retained frames</h5>";
+		html += "<table class=\"table table-sm\"><thead><tr><th scope=\"col\">Block</th><th scope=\"col\">Frames</th><th scope=\"col\">Calls / frame</th><th scope=\"col\">Min</th><th scope=\"col\">Avg</th><th scope=\"col\">Max</th></tr></thead><tbody id=\"profilerBlocks\"></tbody></table>";
+		html += "<script src=\"/js/profiler.js\"></script>";
+
+		return server->FillTemplate("template_page.html", {
+			{ "${TITLE}", "Profiler" },
+			{ "${BODY}", html }
+			});
+	}
+
+	/// Writes the capture's own cost, so the overhead of watching is always visible next to what's watched.
+	static void WriteProfilerCaptureCost(DevServerJSONWriter& writer, const DevServerProfiler& capture)
+	{
+		writer.Key("capture");
+		writer.BeginObject();
+		writer.Key("avg");
+		writer.Value(capture.GetAverageCaptureTime());
+		writer.Key("max");
+		writer.Value(capture.GetMaxCaptureTime());
+		writer.EndObject();
+	}
+
+	bool DevServer::ProfilerHandler::Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response)
+	{
+		if (uri.Size() < 2)
+			return DevServerHandler::Emit(server, uri, params, response);
+
+		const DevServerProfiler& capture = server->profiler_;
+		DevServerJSONWriter writer;
+		if (uri[1].Compare("Frames", false) == 0)
+		{
+			// frames are [sequence, frame, time us, capture us, truncated]
+			const unsigned long long since = strtoull(GetURIParam(params, "since").CString(), nullptr, 10);
+			Vector<DevProfilerFrame> frames;
+			const unsigned long long next = capture.ReadSince(since, false, frames);
+
+			writer.BeginObject();
+			writer.Key("next");
+			writer.Value(next);
+			WriteProfilerCaptureCost(writer, capture);
+			writer.Key("frames");
+			writer.BeginArray();
+			for (const auto& frame : frames)
+			{
+				writer.BeginArray();
+				writer.Value(frame.sequence_);
+				writer.Value(frame.frame_);
+				writer.Value(frame.time_);
+				writer.Value(frame.captureTime_);
+				writer.Value(frame.truncated_);
+				writer.EndArray();
+			}
+			writer.EndArray();
+			writer.EndObject();
+		}
+		else if (uri[1].Compare("Blocks", false) == 0)
+		{
+			Vector<DevProfilerFrame> frames;
+			capture.ReadSince(0, true, frames);
+			// read after the frames so every name they use is in it
+			Vector<String> names;
+			capture.GetNames(names);
+
+			// a block is identified by its path, ie. its name under its parent's identity
+			struct Aggregate {
+				unsigned parent_;
+				unsigned name_;
+				unsigned depth_;
+				unsigned frames_;
+				unsigned long long calls_;
+				unsigned min_;
+				unsigned max_;
+				unsigned long long total_;
+			};
+			PODVector<Aggregate> aggregates;
+			HashMap<unsigned long long, unsigned> aggregateIndices;
+			PODVector<unsigned> nodeAggregates;
+			for (const auto& frame : frames)
+			{
+				nodeAggregates.Resize(frame.nodes_.Size());
+				for (unsigned i = 0; i < frame.nodes_.Size(); ++i)
+				{
+					const DevProfilerNode& node = frame.nodes_[i];
+					const unsigned parent = node.parent_ < i ? nodeAggregates[node.parent_] : M_MAX_UNSIGNED;
+					const unsigned long long key = (unsigned long long)parent << 32 | node.name_;
+					auto found = aggregateIndices.Find(key);
+					unsigned index;
+					if (found == aggregateIndices.End())
+					{
+						index = aggregates.Size();
+						aggregateIndices[key] = index;
+						Aggregate aggregate = { parent, node.name_, node.depth_, 0, 0, M_MAX_UNSIGNED, 0, 0 };
+						aggregates.Push(aggregate);
+					}
+					else
+						index = found->second_;
+
+					Aggregate& aggregate = aggregates[index];
+					++aggregate.frames_;
+					aggregate.calls_ += node.count_;
+					aggregate.min_ = Min(aggregate.min_, node.time_);
+					aggregate.max_ = Max(aggregate.max_, node.time_);
+					aggregate.total_ += node.time_;
+					nodeAggregates[i] = index;
+				}
+			}
+
+			// blocks are [id, parent id or -1, name, depth, frames, calls per frame, min us, avg us, max us]
+			writer.BeginObject();
+			writer.Key("frames");
+			writer.Value(frames.Size());
+			WriteProfilerCaptureCost(writer, capture);
+			writer.Key("blocks");
+			writer.BeginArray();
+			for (unsigned i = 0; i < aggregates.Size(); ++i)
+			{
+				const Aggregate& aggregate = aggregates[i];
+				writer.BeginArray();
+				writer.Value(i);
+				writer.Value(aggregate.parent_ == M_MAX_UNSIGNED ? -1 : (int)aggregate.parent_);
+				writer.Value(aggregate.name_ < names.Size() ? names[aggregate.name_] : String::EMPTY);
+				writer.Value(aggregate.depth_);
+				writer.Value(aggregate.frames_);
+				writer.Value((float)((double)aggregate.calls_ / aggregate.frames_));
+				writer.Value(aggregate.min_);
+				writer.Value((float)((double)aggregate.total_ / aggregate.frames_));
+				writer.Value(aggregate.max_);
+				writer.EndArray();
+			}
+			writer.EndArray();
+			writer.EndObject();
+		}
+		else
+		{
+			DevProfilerFrame frame;
+			if (!capture.Read(strtoull(GetURIParam(params, "sequence").CString(), nullptr, 10), frame, true))
+				return false;
+			Vector<String> names;
+			capture.GetNames(names);
+
+			// a flame chart: children are laid end to end from their parent's start, as the profiler keeps durations and not timestamps
+			PODVector<unsigned> childEnds(frame.nodes_.Size());
+			unsigned topEnd = 0;
+			writer.BeginObject();
+			writer.Key("sequence");
+			writer.Value(frame.sequence_);
+			writer.Key("frame");
+			writer.Value(frame.frame_);
+			writer.Key("time");
+			writer.Value(frame.time_);
+			writer.Key("truncated");
+			writer.Value(frame.truncated_);
+			// nodes are [name, depth, start us, time us, calls]
+			writer.Key("nodes");
+			writer.BeginArray();
+			for (unsigned i = 0; i < frame.nodes_.Size(); ++i)
+			{
+				const DevProfilerNode& node = frame.nodes_[i];
+				unsigned start = 0;
+				if (node.parent_ < i)
+				{
+					start = childEnds[node.parent_];
+					childEnds[node.parent_] += node.time_;
+				}
+				else
+				{
+					// top-level blocks follow one another
+					start = topEnd;
+					topEnd += node.time_;
+				}
+				childEnds[i] = start;
+
+				writer.BeginArray();
+				writer.Value(node.name_ < names.Size() ? names[node.name_] : String::EMPTY);
+				writer.Value(node.depth_);
+				writer.Value(start);
+				writer.Value(node.time_);
+				writer.Value(node.count_);
+				writer.EndArray();
+			}
+			writer.EndArray();
+			writer.EndObject();
+		}
+
+		response.SetContentType("application/json");
+		response.AddHeader("Cache-Control", "no-cache");
+		response += writer.GetBuffer();
+		return true;
+	}
+
+	void DevServer::ProfilerHandler::WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI)
+	{
+		titleAndURI.Push(Pair<String, String>("Profiler", "/Profiler"));
+	}
+
+	String EscapeHTML(const String& src)
+	{
+		String r;
+		r.Reserve(src.Length());
+		for (unsigned i = 0; i < src.Length(); ++i)
+		{
+			switch (src[i])
+			{
+			case '<':
+				r += "&lt;";
+				break;
+			case '>':
+				r += "&gt;";
+				break;
+			case '&':
+				r += "&amp;";
+				break;
+			case '"':
+				r += "&quot;";
+				break;
+			default:
+				r += src[i];
+			}
+		}
+		return r;
+	}
+
 	String ToHTMLSafe(const String& src)
 	{
 		String r = src;
@@ -647,6 +2897,13 @@ namespace Urho3D
 	{
 		return uri.Split('/');
 	}
+	String GetURIParam(const VariantMap& params, const String& name, const String& defaultValue)
+	{
+		auto found = params.Find(name);
+		if (found != params.End())
+			return found->second_.GetString();
+		return defaultValue;
+	}
 	String ComposeURI(const StringVector& v)
 	{
 		String r;
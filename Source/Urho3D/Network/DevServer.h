@@ -1,27 +1,51 @@
 #pragma once
 
+#include "../Container/HashSet.h"
 #include "../Core/Object.h"
 #include "../IO/VectorBuffer.h"
 #include "../Resource/Image.h"
 #include "../Scene/Scene.h"
 #include "../Core/Mutex.h"
+#include "../Network/DevServerCommands.h"
+#include "../Network/DevServerLog.h"
+#include "../Network/DevServerMetrics.h"
+#include "../Network/DevServerProfiler.h"
+#include "../Network/DevServerResponse.h"
+#include "../Network/DevServerRouter.h"
+#include "../Network/DevServerSearch.h"
+#include "../Network/DevServerStats.h"
+#include "../Network/DevServerStream.h"
+#include "../Network/DevServerWatch.h"
 
 #include <Civetweb/civetweb.h>
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
 
 namespace Urho3D
 {
 	class DevServer;
+	class HiresTimer;
 
 	/// Interface for overriding URI handling.
+	/// Handlers that register routes are dispatched through the router, Handles/HandlesPost is only consulted for handlers that register none.
 	struct URHO3D_API DevServerHandler {
+		/// Register URI patterns for this handler, captured segments arrive in the params of EmitHTML/EmitData.
+		virtual void RegisterRoutes(DevServerRouter& router) { }
 		virtual bool Handles(DevServer*, const Vector<String>& uri) = 0;
 		virtual bool HandlesPost(DevServer*, const Vector<String>& uri) { return false; }
 		virtual String EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params) = 0;
+		/// Writes the response for a GET, override to stream large pages instead of returning them whole from EmitHTML.
+		/// Return false (before writing anything) to decline the request.
+		virtual bool Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response);
 		virtual void DoPost(DevServer*, const Vector<String>& uri, const String& postData) { }
+		/// Cheap version tag for the GET response, empty when the handler can't tell.
+		/// When it matches the client's If-None-Match a 304 is sent and Emit isn't called; pages using the generated menu should fold in GetNavigationGeneration.
+		virtual String GetETag(DevServer* server, const Vector<String>& uri, const VariantMap& params) { return String(); }
 
-		virtual void Search(DevServer* server, const StringVector& searchTerms, PODVector<Pair<String,String>>& results) { }
+		/// Adds (title, URL) results for /Search, a term ending in * matches as a prefix and otherwise as a substring. Called from request threads.
+		virtual void Search(DevServer* server, const StringVector& searchTerms, Vector<Pair<String,String>>& results) { }
 		virtual void WriteNavigation(DevServer* server, Vector<Pair<String,String>>& titleAndURI) { }
 		virtual void WriteRawNavigation(DevServer* server, String& data) { }
 	};
@@ -29,24 +53,41 @@ namespace Urho3D
 	/// A data handler is a special base, one that serves binary data (downloads)
 	struct URHO3D_API DevServerDataHandler : DevServerHandler {
 		virtual String EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params) { return String(); }
-		virtual bool EmitData(DevServer* server, const Vector<String>& uri, String& mimeType, VectorBuffer& buffer) = 0;
+		virtual bool EmitData(DevServer* server, const Vector<String>& uri, String& mimeType, VectorBuffer& buffer) { return false; }
+		/// Variant that receives route captures, defaults to the capture-less version.
+		virtual bool EmitData(DevServer* server, const Vector<String>& uri, const VariantMap& params, String& mimeType, VectorBuffer& buffer) { return EmitData(server, uri, mimeType, buffer); }
+		/// Sends whatever EmitData produced with its length.
+		virtual bool Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response) override;
 	};
 
 	/// An embedded HTTP server for retrieving diagnostic information at runtime.
 	/// Built-in features:
 	///		- trivial publishing of text/images to urls
-	///		- localhost/Log, displays the Urho3D log
+	///		- localhost/Log, displays the Urho3D log and live-appends new messages
+	///		- localhost/Log?since=&level=&limit=, returns messages newer than a sequence cursor as JSON
 	///		- localhost/Resources, displays the resource cache contents
 	///		- localhost/ShaderCache, displays the loaded shader combinations
 	///		- localhost/ResourceCache/__resource_name__, retrieves data for a resource (if possible)
-	///		- localhost/Search, performs basic search functionality
+	///		- localhost/Search?q=, finds scenes and nodes by name, tag, variable or component type (?format=json for JSON)
 	///		- localhost/Scenes, displays registered scenes for viewing
+	///		- localhost/api/Scenes/__scene__/Node/__id__ and .../Component/__id__, an object's attributes as JSON (?attrs=Position,Rotation to pick some)
+	///		- localhost/DevServer/Compression, displays per-endpoint compression totals
+	///		- localhost/Pages/__name__.png, the PNG of a published image (cached until it's republished)
+	///		- localhost/Stream/Log and localhost/Stream/Pages, Server-Sent Events of new log messages and published pages
+	///		- ws://localhost/Watch, WebSocket for watching and editing node/component attributes live
 	class URHO3D_API DevServer : public Object
 	{
 		URHO3D_OBJECT(DevServer, Object);
 		friend class SceneLister;
 		friend class SceneContent;
 	public:
+		/// Byte budget shared by published image history unless SetPublishHistory is given another.
+		static const unsigned long long DEFAULT_HISTORY_BUDGET = 256ull * 1024 * 1024;
+		/// Default microseconds per frame spent running commands queued by requests.
+		static const unsigned DEFAULT_COMMAND_BUDGET = 2000;
+		/// Default milliseconds a request waits for work it has handed to the main thread.
+		static const unsigned DEFAULT_MAIN_THREAD_TIMEOUT = 500;
+
 		DevServer(Context*);
 		virtual ~DevServer();
 		static void RegisterObject(Context*);
@@ -55,7 +96,7 @@ namespace Urho3D
 		void RestartServer(int port);
 		/// Returns true if the server is presumably actively running.
 		bool IsServerLive() const;
-		/// Add a response handler implementation.
+		/// Add a response handler implementation, its routes are registered immediately.
 		void AddHandler(DevServerHandler* handler);
 
 		/// Use to read a file from the /web directory - for mail-merge/templates.
@@ -71,36 +112,152 @@ namespace Urho3D
 		String Accordian(const String& key, const String& header, const String& content) const;
 		/// Emits a bootstrap grouped list.
 		void GroupedList(String& holder, const StringVector& items) const;
+		/// Fills the ${...} placeholders of a /web template, ${MENU} is always the generated navigation.
+		/// Templates are compiled once and kept in memory, they're recompiled when the file's modification time changes.
 		String FillTemplate(const String& templateFile, const HashMap<String, String>& items) const;
+		/// Streams a filled template into a response, ${BODY} is produced by bodyWriter when one is given.
+		void WriteTemplate(DevServerResponse& response, const String& templateFile, const HashMap<String, String>& items, const std::function<void(DevServerResponse&)>& bodyWriter = nullptr) const;
 		 
 	// Utilities
 		/// Creates a simple-page handler for a time-stamped preformated set of text.
 		void Publish(const String& title, const String& content);
 		/// Creates a simple-page handler for a time-stamped image.
 		void Publish(const String& title, const SharedPtr<Image>& content);
+		/// Creates a simple-page handler for float pixels (HDR colour, depth, heights), converted to a viewable 8-bit image.
+		void Publish(const String& title, const float* pixels, unsigned width, unsigned height, unsigned components);
+		/// Keeps up to framesPerTitle versions of each published image for the scrubber on its page, 0 (the default) keeps only the latest.
+		/// Frames of all titles share byteBudget, the least recently published or viewed is evicted first but the latest of a title never is.
+		void SetPublishHistory(unsigned framesPerTitle, unsigned long long byteBudget = DEFAULT_HISTORY_BUDGET);
+		/// Returns the number of frames kept per title, 0 when history is off.
+		unsigned GetPublishHistoryFrames() const { return historyFrames_; }
+		/// Returns the bytes held by image history.
+		unsigned long long GetPublishHistoryBytes() const { return historyBytes_; }
+		/// Returns the versions and time stamps of a title's history that can be fetched with Pages/<title>.png?frame=, oldest first.
+		Vector<Pair<unsigned, String> > GetPublishHistory(const String& title) const;
+		/// Records a sample of a numeric channel charted on /Metrics, cheap enough for every frame and safe from any thread.
+		void PublishValue(const char* name, float value) { metrics_.PublishValue(name, value); }
+		void PublishValue(const String& name, float value) { metrics_.PublishValue(name.CString(), value); }
+		/// Adds to a counter charted on /Metrics, its total over each frame becomes one sample. Any thread.
+		void PublishCounter(const char* name, int delta = 1) { metrics_.PublishCounter(name, delta); }
+		void PublishCounter(const String& name, int delta = 1) { metrics_.PublishCounter(name.CString(), delta); }
+		/// Returns the numeric channels behind PublishValue and PublishCounter.
+		DevServerMetrics& GetMetrics() { return metrics_; }
+		/// Returns the per-frame capture of the engine Profiler shown on /Profiler.
+		const DevServerProfiler& GetProfilerCapture() const { return profiler_; }
 		/// Adds a link to the standard generated menu, use for adding custom links (ie. link to PBR theory or something).
 		void AddStaticLink(const String& title, const String& url);
 		void RegisterCommand(const String& name, std::function<void(Context*)> cmd) { RegisterCommand(name, String(), cmd); }
 		void RegisterCommand(const String& name, const String& tip, std::function<void(Context*)> cmd);
 
-		void AddScene(SharedPtr<Scene> scene) { scenes_.Push(scene); }
-		void RemoveScene(SharedPtr<Scene> scene) { scenes_.Remove(scene); }
+		/// Scenes, published pages, commands and links are registered on the main thread and reach requests with the next frame's snapshot.
+		/// Registers a scene for viewing and builds its search index, which then follows the scene's events.
+		/// The scene is only weakly referenced and drops out by itself once destroyed. Its id and URL slug are fixed here and
+		/// kept for as long as it's registered, renaming the scene only changes what the menu shows. Adding a scene twice returns its id.
+		unsigned AddScene(Scene* scene);
+		void RemoveScene(Scene* scene);
+		/// Finds a registered scene by its URL slug, case-insensitive. Main thread.
+		Scene* FindScene(const String& slug) const;
+		/// Returns a registered scene by id, null once it's been removed or destroyed. Main thread.
+		Scene* GetScene(unsigned id) const;
+		/// Returns a registered scene's URL slug, empty if it isn't registered. Main thread.
+		const String& GetSceneSlug(unsigned id) const;
+		/// The slug a scene name starts from: trimmed, anything other than letters, digits, - and _ becomes an underscore,
+		/// and an unnamed scene is "Unnamed_scene". Scenes whose names give the same slug get their id appended.
+		static String MakeSceneSlug(const String& name);
+
+		/// Enables gzip/deflate for generated pages and the precompressed /web files, on by default.
+		void SetCompressionEnabled(bool enabled) { compressionEnabled_ = enabled; }
+		/// Smallest generated response that gets compressed, 1 KB by default.
+		void SetCompressionThreshold(unsigned bytes) { compressionThreshold_ = bytes; }
+
+		/// Totals for the responses of one endpoint, to weigh bandwidth saved against CPU spent.
+		struct CompressionStats {
+			CompressionStats() : responses_(0), rawBytes_(0), sentBytes_(0), usec_(0) { }
+			unsigned responses_;
+			unsigned long long rawBytes_;
+			unsigned long long sentBytes_;
+			long long usec_;
+		};
+		/// Returns compression totals keyed by route pattern (or /web file path).
+		HashMap<String, CompressionStats> GetCompressionStats() const;
+		/// Returns the server's timings of its own requests and main-thread work, shown on /DevServer/Stats.
+		DevServerStats& GetStats() { return stats_; }
+		const DevServerStats& GetStats() const { return stats_; }
+		/// Limits the microseconds each frame spends on commands queued by requests (attribute edits, /Commands), 0 for no limit.
+		/// Commands over the budget wait for the next frame, at least one runs per frame.
+		void SetCommandBudget(unsigned usec) { commandBudget_ = usec; }
+		unsigned GetCommandBudget() const { return commandBudget_; }
+		/// Returns the queue of commands waiting for the main thread, for its depth and latency.
+		const DevServerCommandQueue& GetCommandQueue() const { return commandQueue_; }
+
+		/// Marks the generated menu as stale, handlers call this when their WriteNavigation/WriteRawNavigation output changes.
+		void InvalidateNavigation() { ++navGeneration_; }
+		/// Returns the current menu generation, for use in ETags of pages that include the menu.
+		unsigned GetNavigationGeneration() const { return navGeneration_; }
+		/// Returns the retained log messages.
+		const DevServerLogRing& GetLogRing() const { return logRing_; }
+		/// Returns a counter bumped whenever any resource finishes reloading.
+		unsigned GetResourceGeneration() const { return resourceGeneration_; }
+		/// Returns the Server-Sent Events hub, custom channels broadcast here are served at /Stream/<channel>.
+		DevServerStreamHub& GetStreamHub() { return streamHub_; }
+		/// Runs work on the main thread at the next frame boundary, in order with the other queued commands, and waits up to timeoutMs for it.
+		/// For request threads that need live nodes and components. Returns false if it didn't start in time, it is then dropped and never runs,
+		/// so work must capture by value (shared_ptr for results) rather than reference the caller's stack.
+		bool RunOnMainThread(std::function<void()> work, unsigned timeoutMs = DEFAULT_MAIN_THREAD_TIMEOUT);
 
 	private:
 		void AddDeferredCommand(std::function<void()> cmd);
 
-		/// Emits navigation links.
+		/// Emits navigation links, cached until the navigation generation changes.
 		String GenerateNavigation() const;
+		/// Asks all handlers and registered items for their links.
+		String BuildNavigation() const;
+
+		/// A /web template split into literal text and ${...} placeholders.
+		struct CompiledTemplate {
+			struct Segment {
+				/// Literal text, or the full placeholder (ie. "${BODY}").
+				String text_;
+				bool placeholder_;
+			};
+			Vector<Segment> segments_;
+			/// Combined length of the literal segments.
+			unsigned literalLength_;
+		};
+		/// Cached template and the file state it was compiled from.
+		struct TemplateEntry {
+			TemplateEntry() : modifiedTime_(0), checkedTime_(0) { }
+			std::shared_ptr<const CompiledTemplate> template_;
+			unsigned modifiedTime_;
+			unsigned checkedTime_;
+		};
+		/// Returns the compiled template, recompiling it if the file changed on disk.
+		std::shared_ptr<const CompiledTemplate> GetTemplate(const String& templateFile) const;
 
 		/// When a new frame is called we'll execute any queued commands.
 		void OnNewFrame(StringHash, VariantMap&);
 		/// Handler for Urho3D log event.
 		void OnLog(StringHash, VariantMap&);
+		/// Handler for resource reloads, bumps the resource generation.
+		void OnResourceReloaded(StringHash, VariantMap&);
 
 		static int BeginRequest(struct mg_connection*);
+		/// Precompresses the text files under the web directory into memory.
+		void PrecompressWebFiles();
+		/// Sends a precompressed /web file if the client accepts compression, returns false to let civetweb serve the file.
+		bool SendStaticAsset(struct mg_connection*, const String& uri);
+		/// Adds a response to the compression totals.
+		void RecordCompression(const String& endpoint, unsigned rawBytes, unsigned sentBytes, long long usec);
+		/// Runs a GET handler and writes its response, returns false if the handler declined.
+		/// The timer started with the request and covers routing up to the call.
+		static bool DispatchGet(struct mg_connection*, DevServer* server, const DevServerRoute& route, const Vector<String>& uri, const VariantMap& params, HiresTimer& timer);
 		static int SendErrorPage(struct mg_connection*, int status);
 
-		/// Used to send a regular HTML 200 response.
+		/// Returns true if the request's If-None-Match holds the (quoted) ETag.
+		static bool MatchesETag(struct mg_connection*, const String& etag);
+		/// Used to send a 304 for a matched ETag.
+		static void SendNotModified(struct mg_connection*, const String& etag);
+		/// Used to send a regular HTML 200 response, with its length.
 		static void SendHTMLResponse(struct mg_connection*, const String& html);
 		/// Used to send a file 200 response.
 		static void SendDataResponse(struct mg_connection*, const String& mimeType, const VectorBuffer& data);
@@ -113,18 +270,126 @@ namespace Urho3D
 			SharedPtr<Image> image_;
 			String timeStamp_;
 			String text_;
+			/// Unique per Publish call, used as the ETag.
+			unsigned version_;
 		};
+		/// Source of StaticItem versions.
+		unsigned publishCounter_;
+		/// Bumped on every resource reload.
+		std::atomic<unsigned> resourceGeneration_;
 		/// Collection of simple pages for text/image dumps.
 		HashMap<String, StaticItem> simpleTexts_;
-		/// History of log messages (printed in reverse).
-		Vector<String> log_;
+		/// Announces a published page on /Stream/Pages.
+		void BroadcastPage(const String& title, const StaticItem& item);
+		/// Marks a title as published this frame, it's announced once the next snapshot shows it.
+		void QueuePageBroadcast(const String& title);
+		/// An encoded published image, shared with the requests sending it.
+		typedef std::shared_ptr<const PODVector<unsigned char>> EncodedImage;
+		/// Returns the PNG of a published image version, encoding it on first request.
+		EncodedImage GetPublishedPNG(const String& title, unsigned version, const Image* image);
+		/// Drops the cached encoding of the item currently published under title.
+		void ReleasePublishedImage(const String& title);
+		/// The newest PNG encoded for each published image title with its StaticItem version, filled lazily by the request threads.
+		HashMap<String, Pair<unsigned, EncodedImage> > encodedImages_;
+		Mutex encodedImagesMutex_;
+		/// A published image version kept for the scrubber.
+		struct HistoryFrame {
+			/// Holds one reference to the image, request threads borrow it through the atomic count so it can't be freed under them.
+			std::shared_ptr<Image> image_;
+			String timeStamp_;
+			unsigned version_;
+			/// Bytes counted against the budget.
+			unsigned size_;
+			/// historyTick_ of the last publish or request, the lowest is evicted first.
+			unsigned lastUsed_;
+			/// Still shares the publisher's image, settled (kept or copied) at the start of the next frame.
+			bool pending_;
+		};
+		/// Adds a just published image to its title's history and evicts what no longer fits.
+		void RecordHistory(const String& title, const StaticItem& item);
+		/// Settles pending frames: an image only the history still holds is kept as is, one the publisher kept is copied.
+		void SettleHistory();
+		/// Drops frames over the per-title count and the byte budget, main thread only.
+		void EvictHistory();
+		/// Drops a title's whole history.
+		void ClearHistory(const String& title);
+		/// Removes frames, holding back the images requests are still sending.
+		void RetireHistory(Vector<HistoryFrame>& frames);
+		/// Returns a settled frame of a title's history for a request thread, null if it's gone or still pending.
+		std::shared_ptr<Image> AcquireHistoryFrame(const String& title, unsigned version);
+		/// Image history by title, oldest frame first.
+		HashMap<String, Vector<HistoryFrame>> history_;
+		/// Titles whose publisher keeps its image after publishing, their frames are copied right away.
+		HashSet<String> retainedTitles_;
+		/// Images of cleared frames that a request was still sending, released on the main thread once it's done.
+		Vector<std::shared_ptr<Image>> retiredHistory_;
+		unsigned historyFrames_;
+		unsigned long long historyBudget_;
+		unsigned long long historyBytes_;
+		unsigned historyTick_;
+		mutable Mutex historyMutex_;
+		/// Recent log messages, written by OnLog and read lock-free by the request threads.
+		DevServerLogRing logRing_;
+		/// Numeric channels from PublishValue and PublishCounter.
+		DevServerMetrics metrics_;
+		/// Recent frames of the engine Profiler, captured at the start of each frame.
+		DevServerProfiler profiler_;
+		/// Server-Sent Events clients, fed from OnLog and Publish.
+		DevServerStreamHub streamHub_;
+		/// WebSocket attribute watches, updated every frame.
+		std::unique_ptr<DevServerWatchHub> watchHub_;
 		/// All available handlers currently registered, processed in sequence.
 		Vector<DevServerHandler*> handlers_;
+		/// URI patterns registered by handlers.
+		DevServerRouter router_;
+		/// Handlers that registered no routes and are polled through Handles/HandlesPost.
+		Vector<DevServerRoute> legacyHandlers_;
 		/// Error-handler function.
 		std::function<String(int status)> errorHandler_;
 		/// Extension links for the generated menu (to link to custom content, help URLs, etc).
 		Vector<Pair<String, String>> staticLinks_;
-		Vector<SharedPtr<Scene>> scenes_;
+		/// A scene given to AddScene.
+		struct RegisteredScene {
+			WeakPtr<Scene> scene_;
+			unsigned id_;
+			String slug_;
+			SharedPtr<DevSceneIndex> index_;
+		};
+		/// Registered scenes by id, in the order they were added.
+		HashMap<unsigned, RegisteredScene> scenes_;
+		/// Scene ids by lower-cased slug.
+		HashMap<String, unsigned> sceneSlugs_;
+		unsigned nextSceneId_;
+		/// Bumped whenever anything that appears in the menu changes.
+		std::atomic<unsigned> navGeneration_;
+		/// Last generated menu and the generation it was built for.
+		mutable String navCache_;
+		mutable unsigned navCacheGeneration_;
+		mutable Mutex navMutex_;
+		/// A /web file held as a bare deflate stream that's framed for gzip or deflate as it's sent.
+		struct StaticAsset {
+			String fileName_;
+			String mimeType_;
+			PODVector<unsigned char> deflate_;
+			unsigned rawSize_;
+			unsigned crc_;
+			unsigned adler_;
+			unsigned modifiedTime_;
+		};
+		/// Reads and compresses a /web file, returns null if it isn't a text asset or doesn't shrink.
+		static std::shared_ptr<StaticAsset> CompressWebFile(Context* ctx, const String& fileName);
+		/// Precompressed /web files by URI.
+		HashMap<String, std::shared_ptr<const StaticAsset>> staticAssets_;
+		Mutex staticMutex_;
+		bool compressionEnabled_;
+		unsigned compressionThreshold_;
+		HashMap<String, CompressionStats> compressionStats_;
+		mutable Mutex compressionMutex_;
+		/// Request latency per endpoint and the cost of OnNewFrame/OnLog.
+		DevServerStats stats_;
+		/// Compiled templates by file name.
+		mutable HashMap<String, TemplateEntry> templates_;
+		mutable Mutex templateMutex_;
 
 		struct CommandItem {
 			String title_;
@@ -134,35 +399,151 @@ namespace Urho3D
 		};
 		std::vector<CommandItem> commands_;
 
-		Mutex mutex_;
-		std::vector<std::function<void()>> deferredCommand_;
+		/// What request threads see of the main thread's scenes, published pages, commands and links, immutable once published.
+		/// The main thread builds a new one at the frame boundary when something changed and swaps it in with an atomic store,
+		/// requests load it once and keep the reference for as long as they use anything in it.
+		/// Replaced snapshots are retired and destroyed on the main thread once no request holds them,
+		/// so the Urho references they carry (scenes, images) are never released off the main thread.
+		struct Snapshot {
+			/// A registered scene, which is only ever touched on the main thread through its id (see RunOnMainThread).
+			struct SceneEntry {
+				unsigned id_;
+				SharedPtr<DevSceneIndex> index_;
+				/// Scene::GetName when the snapshot was taken.
+				String name_;
+				String urlName_;
+			};
+
+			/// Returns the published page with the exact title, null if there's none.
+			const StaticItem* FindPage(const String& title) const;
+			/// Returns the published image a Pages/<title>.png request refers to and its title, null if there's none.
+			const StaticItem* FindImage(const String& page, String& title) const;
+			/// Finds a scene by its URL slug, case-insensitive, null if there's none.
+			const SceneEntry* FindScene(const String& slug) const;
+
+			/// Bumped with every published snapshot.
+			unsigned version_;
+			/// Published pages by title, shared between snapshots until republished.
+			HashMap<String, std::shared_ptr<const StaticItem>> pages_;
+			Vector<SceneEntry> scenes_;
+			/// Positions in scenes_ by lower-cased slug.
+			HashMap<String, unsigned> sceneSlugs_;
+			/// Commands without their functions, those stay with the main thread.
+			std::vector<CommandItem> commands_;
+			Vector<Pair<String, String>> staticLinks_;
+		};
+		/// Returns the current snapshot. Any thread, never blocks.
+		std::shared_ptr<const Snapshot> AcquireSnapshot() const { return std::atomic_load(&snapshot_); }
+		/// Publishes a new snapshot if anything changed since the last one and frees retired ones. Main thread, once per frame.
+		void UpdateSnapshot();
+		/// Only touched with std::atomic_load/std::atomic_store.
+		std::shared_ptr<const Snapshot> snapshot_;
+		/// Replaced snapshots that requests may still hold.
+		Vector<std::shared_ptr<const Snapshot>> retiredSnapshots_;
+		/// Snapshot copies of the published pages by title, reused while a page's version and image stay the same.
+		HashMap<String, std::shared_ptr<const StaticItem>> snapshotPages_;
+		/// Titles published since the last snapshot, announced on /Stream/Pages once requests can see them.
+		Vector<String> pendingPageBroadcasts_;
+		bool snapshotDirty_;
+		/// Set when the next snapshot changes the menu (titles, scenes, commands, links), republishing a page doesn't.
+		bool navigationDirty_;
+
+		/// Commands from request threads, run at the start of a frame.
+		DevServerCommandQueue commandQueue_;
+		std::atomic<unsigned> commandBudget_;
 
 		/// Internal handler for displaying the /Log page
 		struct LogHandler : DevServerHandler {
+			virtual void RegisterRoutes(DevServerRouter& router) override;
 			virtual bool Handles(DevServer*, const Vector<String>& uri) override;
 			virtual String EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params) override;
+			virtual bool Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response) override;
+			virtual String GetETag(DevServer* server, const Vector<String>& uri, const VariantMap& params) override;
 			virtual void WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI) override;
+			/// Answers /Log?since=&level=&limit= with the newer entries as JSON.
+			bool EmitQuery(DevServer* server, const VariantMap& params, DevServerResponse& response);
 		};
 
 		/// Internal handler for displaying the simple text/image items.
 		struct SimpleHandler : DevServerHandler {
+			virtual void RegisterRoutes(DevServerRouter& router) override;
 			virtual bool Handles(DevServer*, const Vector<String>& uri) override;
 			virtual String EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params) override;
+			/// Sends the cached PNG for Pages/<name>.png, pages go through EmitHTML.
+			virtual bool Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response) override;
+			virtual String GetETag(DevServer* server, const Vector<String>& uri, const VariantMap& params) override;
 			virtual void WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI) override;
 			virtual void WriteRawNavigation(DevServer* server, String& data) override;
 		};
 
 		struct CommandHandler : DevServerHandler {
+			virtual void RegisterRoutes(DevServerRouter& router) override;
 			virtual bool Handles(DevServer*, const Vector<String>& uri) override;
 			virtual bool HandlesPost(DevServer*, const Vector<String>& uri) override;
 			virtual String EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params) override;
 			virtual void DoPost(DevServer*, const Vector<String>& uri, const String& postData) override;
 			virtual void WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI) override;
 		};
+
+		/// Internal handler holding /Stream/{channel} connections open as Server-Sent Events.
+		struct StreamHandler : DevServerHandler {
+			virtual void RegisterRoutes(DevServerRouter& router) override;
+			virtual bool Handles(DevServer*, const Vector<String>& uri) override { return false; }
+			virtual String EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params) override { return String(); }
+			virtual bool Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response) override;
+		};
+
+		/// Internal handler for the /Metrics charts and their JSON.
+		struct MetricsHandler : DevServerHandler {
+			virtual void RegisterRoutes(DevServerRouter& router) override;
+			virtual bool Handles(DevServer*, const Vector<String>& uri) override { return false; }
+			virtual String EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params) override;
+			/// Sends Metrics/Channels and Metrics/Samples/<channel> as JSON, the page itself goes through EmitHTML.
+			virtual bool Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response) override;
+			virtual void WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI) override;
+		};
+
+		/// Internal handler for the /Profiler view and its JSON.
+		struct ProfilerHandler : DevServerHandler {
+			virtual void RegisterRoutes(DevServerRouter& router) override;
+			virtual bool Handles(DevServer*, const Vector<String>& uri) override { return false; }
+			virtual String EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params) override;
+			/// Sends Profiler/Frames, Profiler/Blocks and Profiler/Frame/<sequence> as JSON, the page itself goes through EmitHTML.
+			virtual bool Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response) override;
+			virtual void WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI) override;
+		};
+
+		/// Internal handler for the /DevServer/Compression table.
+		struct CompressionHandler : DevServerHandler {
+			virtual void RegisterRoutes(DevServerRouter& router) override;
+			virtual bool Handles(DevServer*, const Vector<String>& uri) override { return false; }
+			virtual String EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params) override;
+		};
+
+		/// Internal handler for /Search, collects every handler's results (?format=json for JSON).
+		struct SearchHandler : DevServerHandler {
+			virtual void RegisterRoutes(DevServerRouter& router) override;
+			virtual bool Handles(DevServer*, const Vector<String>& uri) override { return false; }
+			virtual String EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params) override;
+			virtual bool Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response) override;
+			virtual void WriteNavigation(DevServer* server, Vector<Pair<String, String>>& titleAndURI) override;
+		};
+
+		/// Internal handler for /DevServer/Stats, the server's own latency and main-thread cost (?format=json for JSON).
+		struct StatsHandler : DevServerHandler {
+			virtual void RegisterRoutes(DevServerRouter& router) override;
+			virtual bool Handles(DevServer*, const Vector<String>& uri) override { return false; }
+			virtual String EmitHTML(DevServer* server, const Vector<String>& uri, const VariantMap& params) override;
+			virtual bool Emit(DevServer* server, const Vector<String>& uri, const VariantMap& params, DevServerResponse& response) override;
+		};
 	};
 
+	/// Escapes &, <, > and " for embedding text in HTML.
+	URHO3D_API String EscapeHTML(const String& src);
 	URHO3D_API String ToHTMLSafe(const String& src);
 	URHO3D_API String FromHTMLSafe(const String& src);
 	URHO3D_API StringVector SliceURI(const String& uri);
+	/// Reads a route capture (or other string parameter) from the params given to a handler.
+	URHO3D_API String GetURIParam(const VariantMap& params, const String& name, const String& defaultValue = String::EMPTY);
 	URHO3D_API String ComposeURI(const StringVector&);
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "DevServerCommands.h"
+
+#include "../Math/MathDefs.h"
+
+#include <chrono>
+
+namespace Urho3D
+{
+
+	/// Monotonic microseconds comparable across threads, unlike a HiresTimer.
+	static long long GetQueueTime()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static unsigned ToDuration(long long usec)
+	{
+		return usec <= 0 ? 0 : (unsigned)Min(usec, (long long)M_MAX_UNSIGNED);
+	}
+
+	DevServerCommandQueue::DevServerCommandQueue() :
+		head_(nullptr),
+		pending_(nullptr),
+		pendingTail_(nullptr),
+		depth_(0),
+		maxDepth_(0),
+		executed_(0),
+		carriedFrames_(0)
+	{
+	}
+
+	DevServerCommandQueue::~DevServerCommandQueue()
+	{
+		Node* lists[] = { head_.exchange(nullptr, std::memory_order_acquire), pending_ };
+		for (Node* node : lists)
+		{
+			while (node)
+			{
+				Node* next = node->next_;
+				delete node;
+				node = next;
+			}
+		}
+	}
+
+	void DevServerCommandQueue::Push(std::function<void()> command)
+	{
+		Node* node = new Node();
+		node->command_ = std::move(command);
+		node->queued_ = GetQueueTime();
+		node->next_ = head_.load(std::memory_order_relaxed);
+		while (!head_.compare_exchange_weak(node->next_, node, std::memory_order_release, std::memory_order_relaxed))
+			;
+
+		const unsigned depth = depth_.fetch_add(1, std::memory_order_relaxed) + 1;
+		unsigned deepest = maxDepth_.load(std::memory_order_relaxed);
+		while (depth > deepest && !maxDepth_.compare_exchange_weak(deepest, depth, std::memory_order_relaxed))
+			;
+	}
+
+	unsigned DevServerCommandQueue::Run(unsigned budgetUsec)
+	{
+		// the stack is newest first, reverse it onto the end of what earlier frames left
+		Node* taken = head_.exchange(nullptr, std::memory_order_acquire);
+		if (taken)
+		{
+			Node* last = taken;
+			Node* reversed = nullptr;
+			while (taken)
+			{
+				Node* next = taken->next_;
+				taken->next_ = reversed;
+				reversed = taken;
+				taken = next;
+			}
+			if (pendingTail_)
+				pendingTail_->next_ = reversed;
+			else
+				pending_ = reversed;
+			pendingTail_ = last;
+		}
+		if (!pending_)
+			return 0;
+
+		const long long start = GetQueueTime();
+		long long now = start;
+		unsigned executed = 0;
+		while (pending_)
+		{
+			Node* node = pending_;
+			pending_ = node->next_;
+			if (!pending_)
+				pendingTail_ = nullptr;
+
+			latency_.Record(ToDuration(now - node->queued_));
+			node->command_();
+			delete node;
+			++executed;
+			depth_.fetch_sub(1, std::memory_order_relaxed);
+
+			now = GetQueueTime();
+			if (budgetUsec && now - start >= budgetUsec)
+				break;
+		}
+
+		runTime_.Record(ToDuration(now - start));
+		executed_.fetch_add(executed, std::memory_order_relaxed);
+		if (pending_)
+			carriedFrames_.fetch_add(1, std::memory_order_relaxed);
+		return executed;
+	}
+}
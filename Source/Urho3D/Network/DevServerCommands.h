@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../Network/DevServerStats.h"
+
+#include <atomic>
+#include <functional>
+
+namespace Urho3D
+{
+
+	/// Commands queued by request threads for the main thread, such as attribute edits and /Commands posts.
+	/// Pushing is a lock-free push onto a Treiber stack, so a request never waits on the frame or on another request.
+	/// The main thread takes the whole stack with one exchange, reverses it to arrival order and runs from that private list
+	/// without holding anything, so commands are free to queue further commands (they run on a later frame).
+	/// With a single consumer that only ever takes the whole stack, nodes are never popped one at a time and ABA can't happen.
+	class URHO3D_API DevServerCommandQueue
+	{
+	public:
+		DevServerCommandQueue();
+		/// Drops commands that never ran.
+		~DevServerCommandQueue();
+
+		/// Queues a command. Any thread, never blocks.
+		void Push(std::function<void()> command);
+		/// Runs queued commands oldest first until budgetUsec is spent (0 for no limit), the rest carry over to the next call.
+		/// At least one command runs per call, so a command longer than the budget can't stall the queue. Main thread.
+		/// Returns the number of commands run.
+		unsigned Run(unsigned budgetUsec);
+
+		/// Returns the number of commands waiting.
+		unsigned GetDepth() const { return depth_.load(std::memory_order_relaxed); }
+		/// Returns the most commands that have been waiting at once.
+		unsigned GetMaxDepth() const { return maxDepth_.load(std::memory_order_relaxed); }
+		/// Returns the number of commands run.
+		unsigned long long GetExecuted() const { return executed_.load(std::memory_order_relaxed); }
+		/// Returns the number of frames that ran out of budget and left commands for later.
+		unsigned long long GetCarriedFrames() const { return carriedFrames_.load(std::memory_order_relaxed); }
+		/// Returns microseconds from queueing a command to it starting.
+		const DevLatencyHistogram& GetLatency() const { return latency_; }
+		/// Returns microseconds spent by each Run that had anything to do.
+		const DevLatencyHistogram& GetRunTime() const { return runTime_; }
+
+	private:
+		struct Node {
+			Node* next_;
+			std::function<void()> command_;
+			/// Microseconds on the queue's clock when pushed.
+			long long queued_;
+		};
+
+		/// Newest first, pushed to by any thread.
+		std::atomic<Node*> head_;
+		/// Oldest first, taken from the stack and carried over between frames. Main thread only.
+		Node* pending_;
+		Node* pendingTail_;
+		std::atomic<unsigned> depth_;
+		std::atomic<unsigned> maxDepth_;
+		std::atomic<unsigned long long> executed_;
+		std::atomic<unsigned long long> carriedFrames_;
+		DevLatencyHistogram latency_;
+		DevLatencyHistogram runTime_;
+	};
+}
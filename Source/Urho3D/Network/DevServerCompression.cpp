@@ -0,0 +1,233 @@
+#include "DevServerCompression.h"
+
+#include "../Core/StringUtils.h"
+
+#include <cstdlib>
+#include <cstring>
+
+extern unsigned char *stbi_zlib_compress(unsigned char *data, int data_len, int *out_len, int quality);
+
+namespace Urho3D
+{
+
+	DevServerEncoding NegotiateEncoding(const char* acceptEncoding)
+	{
+		if (acceptEncoding == nullptr)
+			return DSE_IDENTITY;
+
+		bool gzip = false;
+		bool deflate = false;
+		Vector<String> codings = String(acceptEncoding).Split(',');
+		for (auto coding : codings)
+		{
+			Vector<String> parts = coding.Split(';');
+			if (parts.Empty())
+				continue;
+
+			// "gzip;q=0" explicitly refuses the coding
+			bool refused = false;
+			for (unsigned i = 1; i < parts.Size(); ++i)
+			{
+				String param = parts[i].Trimmed();
+				if (param.StartsWith("q=") && ToFloat(param.Substring(2)) <= 0.0f)
+					refused = true;
+			}
+			if (refused)
+				continue;
+
+			String name = parts[0].Trimmed();
+			if (name.Compare("gzip", false) == 0)
+				gzip = true;
+			else if (name.Compare("deflate", false) == 0)
+				deflate = true;
+		}
+
+		if (gzip)
+			return DSE_GZIP;
+		if (deflate)
+			return DSE_DEFLATE;
+		return DSE_IDENTITY;
+	}
+
+	const char* GetEncodingName(DevServerEncoding encoding)
+	{
+		switch (encoding)
+		{
+		case DSE_DEFLATE:
+			return "deflate";
+		case DSE_GZIP:
+			return "gzip";
+		default:
+			return "identity";
+		}
+	}
+
+	bool IsCompressibleType(const String& mimeType)
+	{
+		return mimeType.StartsWith("text/", false) ||
+			mimeType.Contains("json", false) ||
+			mimeType.Contains("javascript", false) ||
+			mimeType.Contains("xml", false);
+	}
+
+	bool CompressBuffer(const void* data, unsigned size, DevServerEncoding encoding, int quality, PODVector<unsigned char>& dest)
+	{
+		dest.Clear();
+		if (encoding == DSE_IDENTITY || size == 0)
+			return false;
+
+		if (encoding == DSE_DEFLATE)
+		{
+			// HTTP deflate is the zlib format, which is exactly what stb produces
+			int len = 0;
+			unsigned char* zlib = stbi_zlib_compress((unsigned char*)data, (int)size, &len, quality);
+			if (zlib == nullptr)
+				return false;
+			if ((unsigned)len < size)
+			{
+				dest.Resize((unsigned)len);
+				memcpy(&dest[0], zlib, len);
+			}
+			free(zlib);
+			return !dest.Empty();
+		}
+
+		PODVector<unsigned char> raw;
+		unsigned adler = 0;
+		if (!DeflateRaw(data, size, quality, raw, adler))
+			return false;
+
+		PODVector<unsigned char> header, trailer;
+		GetEncodingFrame(encoding, size, CRC32(data, size), adler, header, trailer);
+		const unsigned total = header.Size() + raw.Size() + trailer.Size();
+		if (total >= size)
+			return false;
+
+		dest.Resize(total);
+		memcpy(&dest[0], &header[0], header.Size());
+		if (!raw.Empty())
+			memcpy(&dest[header.Size()], &raw[0], raw.Size());
+		memcpy(&dest[header.Size() + raw.Size()], &trailer[0], trailer.Size());
+		return true;
+	}
+
+	bool DeflateRaw(const void* data, unsigned size, int quality, PODVector<unsigned char>& dest, unsigned& adler)
+	{
+		dest.Clear();
+		int len = 0;
+		unsigned char* zlib = stbi_zlib_compress((unsigned char*)data, (int)size, &len, quality);
+		if (zlib == nullptr)
+			return false;
+		if (len < 6)
+		{
+			free(zlib);
+			return false;
+		}
+
+		// strip the 2 byte zlib header and the big-endian adler32 trailer
+		dest.Resize((unsigned)len - 6);
+		if (!dest.Empty())
+			memcpy(&dest[0], zlib + 2, dest.Size());
+		adler = ((unsigned)zlib[len - 4] << 24) | ((unsigned)zlib[len - 3] << 16) | ((unsigned)zlib[len - 2] << 8) | (unsigned)zlib[len - 1];
+		free(zlib);
+		return true;
+	}
+
+	void GetEncodingFrame(DevServerEncoding encoding, unsigned rawSize, unsigned crc, unsigned adler, PODVector<unsigned char>& header, PODVector<unsigned char>& trailer)
+	{
+		header.Clear();
+		trailer.Clear();
+		if (encoding == DSE_GZIP)
+		{
+			// magic, deflate method, no flags, no mtime, no extra flags, unknown OS
+			const unsigned char gzipHeader[] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+			header.Resize(sizeof(gzipHeader));
+			memcpy(&header[0], gzipHeader, sizeof(gzipHeader));
+
+			trailer.Resize(8);
+			for (unsigned i = 0; i < 4; ++i)
+			{
+				trailer[i] = (unsigned char)(crc >> (i * 8));
+				trailer[4 + i] = (unsigned char)(rawSize >> (i * 8));
+			}
+		}
+		else if (encoding == DSE_DEFLATE)
+		{
+			header.Push(0x78);
+			header.Push(0x5e);
+
+			trailer.Resize(4);
+			for (unsigned i = 0; i < 4; ++i)
+				trailer[i] = (unsigned char)(adler >> ((3 - i) * 8));
+		}
+	}
+
+	unsigned CRC32(const void* data, unsigned size, unsigned crc)
+	{
+		// slicing-by-8, table_[k][i] is the crc of byte i followed by k zero bytes
+		struct CRCTable {
+			CRCTable()
+			{
+				for (unsigned i = 0; i < 256; ++i)
+				{
+					unsigned c = i;
+					for (unsigned k = 0; k < 8; ++k)
+						c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+					table_[0][i] = c;
+				}
+				for (unsigned i = 0; i < 256; ++i)
+				{
+					for (unsigned k = 1; k < 8; ++k)
+						table_[k][i] = table_[0][table_[k - 1][i] & 0xff] ^ (table_[k - 1][i] >> 8);
+				}
+			}
+			unsigned table_[8][256];
+		};
+		static const CRCTable crcTable;
+		const unsigned (*table)[256] = crcTable.table_;
+
+		const unsigned char* bytes = (const unsigned char*)data;
+		crc = ~crc;
+		for (; size >= 8; size -= 8, bytes += 8)
+		{
+			const unsigned lo = crc ^ ((unsigned)bytes[0] | ((unsigned)bytes[1] << 8) | ((unsigned)bytes[2] << 16) | ((unsigned)bytes[3] << 24));
+			const unsigned hi = (unsigned)bytes[4] | ((unsigned)bytes[5] << 8) | ((unsigned)bytes[6] << 16) | ((unsigned)bytes[7] << 24);
+			crc = table[7][lo & 0xff] ^ table[6][(lo >> 8) & 0xff] ^ table[5][(lo >> 16) & 0xff] ^ table[4][lo >> 24] ^
+				table[3][hi & 0xff] ^ table[2][(hi >> 8) & 0xff] ^ table[1][(hi >> 16) & 0xff] ^ table[0][hi >> 24];
+		}
+		for (; size; --size)
+			crc = table[0][(crc ^ *bytes++) & 0xff] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	unsigned Adler32(const void* data, unsigned size, unsigned adler)
+	{
+		// 5552 is the most bytes that can be summed before b can overflow 32 bits
+		const unsigned ADLER_MOD = 65521;
+		const unsigned ADLER_NMAX = 5552;
+
+		const unsigned char* bytes = (const unsigned char*)data;
+		unsigned a = adler & 0xffff;
+		unsigned b = adler >> 16;
+		while (size)
+		{
+			unsigned n = size < ADLER_NMAX ? size : ADLER_NMAX;
+			size -= n;
+			for (; n >= 4; n -= 4, bytes += 4)
+			{
+				a += bytes[0]; b += a;
+				a += bytes[1]; b += a;
+				a += bytes[2]; b += a;
+				a += bytes[3]; b += a;
+			}
+			for (; n; --n)
+			{
+				a += *bytes++;
+				b += a;
+			}
+			a %= ADLER_MOD;
+			b %= ADLER_MOD;
+		}
+		return (b << 16) | a;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../Container/PODVector.h"
+#include "../Container/Str.h"
+
+namespace Urho3D
+{
+
+	/// Content codings the DevServer can produce.
+	enum DevServerEncoding {
+		DSE_IDENTITY = 0,
+		DSE_DEFLATE,
+		DSE_GZIP
+	};
+
+	/// Picks the preferred coding for an Accept-Encoding header value (gzip over deflate), null is treated as identity.
+	URHO3D_API DevServerEncoding NegotiateEncoding(const char* acceptEncoding);
+	/// Content-Encoding token for the coding.
+	URHO3D_API const char* GetEncodingName(DevServerEncoding encoding);
+	/// Returns true for mime types worth compressing (text, json, javascript, xml, svg).
+	URHO3D_API bool IsCompressibleType(const String& mimeType);
+
+	/// Compresses into dest using the coding's framing, returns false if that failed or wouldn't make the data smaller.
+	URHO3D_API bool CompressBuffer(const void* data, unsigned size, DevServerEncoding encoding, int quality, PODVector<unsigned char>& dest);
+	/// Produces a bare deflate stream (no zlib/gzip framing) so it can be framed for either coding later, also returns the adler32 of the input.
+	URHO3D_API bool DeflateRaw(const void* data, unsigned size, int quality, PODVector<unsigned char>& dest, unsigned& adler);
+	/// Builds the header and trailer that turn a bare deflate stream of rawSize input bytes into the coding's format.
+	URHO3D_API void GetEncodingFrame(DevServerEncoding encoding, unsigned rawSize, unsigned crc, unsigned adler, PODVector<unsigned char>& header, PODVector<unsigned char>& trailer);
+
+	/// CRC-32 (as used by gzip and PNG), pass the previous result to continue a running checksum.
+	URHO3D_API unsigned CRC32(const void* data, unsigned size, unsigned crc = 0);
+	/// Adler-32 (as used by zlib), pass the previous result to continue a running checksum.
+	URHO3D_API unsigned Adler32(const void* data, unsigned size, unsigned adler = 1);
+}
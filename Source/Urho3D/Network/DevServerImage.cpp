@@ -0,0 +1,643 @@
+#include "DevServerImage.h"
+
+#include "../Container/Vector.h"
+#include "../Math/MathDefs.h"
+#include "../Network/DevServerCompression.h"
+#include "../Resource/Image.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define DEVIMAGE_SSE2
+	#include <emmintrin.h>
+#endif
+
+extern unsigned char *stbi_zlib_compress(unsigned char *data, int data_len, int *out_len, int quality);
+
+namespace Urho3D
+{
+
+	static inline void WriteBE32(unsigned char* dest, unsigned value)
+	{
+		dest[0] = (unsigned char)(value >> 24);
+		dest[1] = (unsigned char)(value >> 16);
+		dest[2] = (unsigned char)(value >> 8);
+		dest[3] = (unsigned char)value;
+	}
+
+	static inline void WriteLE16(unsigned char* dest, unsigned value)
+	{
+		dest[0] = (unsigned char)value;
+		dest[1] = (unsigned char)(value >> 8);
+	}
+
+	static inline void WriteLE32(unsigned char* dest, unsigned value)
+	{
+		WriteLE16(dest, value);
+		WriteLE16(dest + 2, value >> 16);
+	}
+
+	DevImageFormat ParseImageFormat(const String& name, DevImageFormat defaultFormat)
+	{
+		if (name.Compare("png", false) == 0)
+			return DIF_PNG;
+		if (name.Compare("qoi", false) == 0)
+			return DIF_QOI;
+		if (name.Compare("bmp", false) == 0)
+			return DIF_BMP;
+		if (name.Compare("raw", false) == 0)
+			return DIF_RAW;
+		return defaultFormat;
+	}
+
+	const char* GetImageFormatName(DevImageFormat format)
+	{
+		switch (format)
+		{
+		case DIF_QOI:
+			return "qoi";
+		case DIF_BMP:
+			return "bmp";
+		case DIF_RAW:
+			return "raw";
+		default:
+			return "png";
+		}
+	}
+
+	const char* GetImageMimeType(DevImageFormat format)
+	{
+		switch (format)
+		{
+		case DIF_QOI:
+			return "image/qoi";
+		case DIF_BMP:
+			return "image/bmp";
+		case DIF_RAW:
+			return "application/octet-stream";
+		default:
+			return "image/png";
+		}
+	}
+
+	/// Appends a PNG chunk with its length and CRC.
+	static void WritePNGChunk(PODVector<unsigned char>& dest, const char* type, const unsigned char* data, unsigned size)
+	{
+		const unsigned start = dest.Size();
+		dest.Resize(start + 12 + size);
+		unsigned char* out = &dest[start];
+		WriteBE32(out, size);
+		memcpy(out + 4, type, 4);
+		if (size)
+			memcpy(out + 8, data, size);
+		WriteBE32(out + 8 + size, CRC32(out + 4, size + 4));
+	}
+
+	static inline unsigned char Paeth(int a, int b, int c)
+	{
+		const int p = a + b - c;
+		const int pa = Abs(p - a);
+		const int pb = Abs(p - b);
+		const int pc = Abs(p - c);
+		if (pa <= pb && pa <= pc)
+			return (unsigned char)a;
+		return (unsigned char)(pb <= pc ? b : c);
+	}
+
+	/// Filters one row with the given PNG filter type into out (filter byte excluded).
+	static void FilterRow(int filter, const unsigned char* row, const unsigned char* prior, unsigned stride, unsigned bpp, unsigned char* out)
+	{
+		switch (filter)
+		{
+		case 1:
+			memcpy(out, row, bpp);
+			for (unsigned i = bpp; i < stride; ++i)
+				out[i] = row[i] - row[i - bpp];
+			break;
+		case 2:
+			for (unsigned i = 0; i < stride; ++i)
+				out[i] = row[i] - (prior ? prior[i] : 0);
+			break;
+		case 3:
+			for (unsigned i = 0; i < stride; ++i)
+				out[i] = row[i] - (unsigned char)(((i >= bpp ? row[i - bpp] : 0) + (prior ? prior[i] : 0)) >> 1);
+			break;
+		case 4:
+			for (unsigned i = 0; i < stride; ++i)
+				out[i] = row[i] - Paeth(i >= bpp ? row[i - bpp] : 0, prior ? prior[i] : 0, i >= bpp && prior ? prior[i - bpp] : 0);
+			break;
+		default:
+			memcpy(out, row, stride);
+			break;
+		}
+	}
+
+	/// Sum of the filtered bytes as signed values, the usual estimate of how well a row will compress.
+	static unsigned FilterCost(const unsigned char* filtered, unsigned stride)
+	{
+		unsigned cost = 0;
+		for (unsigned i = 0; i < stride; ++i)
+			cost += (unsigned)Abs((int)(signed char)filtered[i]);
+		return cost;
+	}
+
+	/// Wraps data in a zlib stream of stored (uncompressed) blocks.
+	static void WriteStoredZlib(const unsigned char* data, unsigned size, PODVector<unsigned char>& dest)
+	{
+		const unsigned MAX_STORED = 65535;
+		const unsigned numBlocks = Max(1u, (size + MAX_STORED - 1) / MAX_STORED);
+		dest.Resize(2 + numBlocks * 5 + size + 4);
+		unsigned char* out = &dest[0];
+		*out++ = 0x78;
+		*out++ = 0x01;
+		unsigned remaining = size;
+		for (unsigned block = 0; block < numBlocks; ++block)
+		{
+			const unsigned length = Min(remaining, MAX_STORED);
+			*out++ = block == numBlocks - 1 ? 1 : 0;
+			WriteLE16(out, length);
+			WriteLE16(out + 2, ~length & 0xffff);
+			out += 4;
+			if (length)
+				memcpy(out, data, length);
+			out += length;
+			data += length;
+			remaining -= length;
+		}
+		WriteBE32(out, Adler32(data - size, size));
+	}
+
+	static bool EncodePNG(const unsigned char* pixels, unsigned width, unsigned height, unsigned components, int level, PODVector<unsigned char>& dest)
+	{
+		const unsigned stride = width * components;
+		PODVector<unsigned char> filtered((stride + 1) * height);
+
+		// level 0 skips filtering as it won't be compressed anyway, higher levels trade speed for size
+		PODVector<unsigned char> candidate(level >= 7 ? stride : 0);
+		for (unsigned y = 0; y < height; ++y)
+		{
+			const unsigned char* row = pixels + y * stride;
+			const unsigned char* prior = y ? row - stride : nullptr;
+			unsigned char* out = &filtered[y * (stride + 1)];
+			if (level == 0)
+			{
+				out[0] = 0;
+				memcpy(out + 1, row, stride);
+			}
+			else if (level < 7)
+			{
+				out[0] = 2;
+				FilterRow(2, row, prior, stride, components, out + 1);
+			}
+			else
+			{
+				unsigned bestCost = M_MAX_UNSIGNED;
+				for (int filter = 0; filter < 5; ++filter)
+				{
+					FilterRow(filter, row, prior, stride, components, &candidate[0]);
+					const unsigned cost = FilterCost(&candidate[0], stride);
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						out[0] = (unsigned char)filter;
+						memcpy(out + 1, &candidate[0], stride);
+					}
+				}
+			}
+		}
+
+		PODVector<unsigned char> zlib;
+		if (level == 0)
+			WriteStoredZlib(filtered.Buffer(), filtered.Size(), zlib);
+		else
+		{
+			// stb's quality is its hash chain length, it clamps anything below 5
+			int len = 0;
+			unsigned char* compressed = stbi_zlib_compress(filtered.Buffer(), (int)filtered.Size(), &len, 3 + level * 2);
+			if (!compressed)
+				return false;
+			zlib.Resize((unsigned)len);
+			memcpy(zlib.Buffer(), compressed, len);
+			free(compressed);
+		}
+
+		static const unsigned char COLOR_TYPES[] = { 0, 0, 4, 2, 6 };
+		unsigned char header[13];
+		WriteBE32(header, width);
+		WriteBE32(header + 4, height);
+		header[8] = 8;
+		header[9] = COLOR_TYPES[components];
+		header[10] = header[11] = header[12] = 0;
+
+		static const unsigned char SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+		dest.Clear();
+		dest.Reserve(8 + 25 + 12 + zlib.Size() + 12);
+		dest.Insert(dest.End(), SIGNATURE, SIGNATURE + 8);
+		WritePNGChunk(dest, "IHDR", header, 13);
+		WritePNGChunk(dest, "IDAT", zlib.Buffer(), zlib.Size());
+		WritePNGChunk(dest, "IEND", nullptr, 0);
+		return true;
+	}
+
+	static bool EncodeQOI(const unsigned char* pixels, unsigned width, unsigned height, unsigned components, PODVector<unsigned char>& dest)
+	{
+		// gray is widened to RGB, QOI only knows 3 and 4 channels
+		const unsigned channels = (components == 2 || components == 4) ? 4 : 3;
+		const unsigned numPixels = width * height;
+		dest.Resize(14 + numPixels * (channels + 1) + 8);
+
+		unsigned char* out = &dest[0];
+		memcpy(out, "qoif", 4);
+		WriteBE32(out + 4, width);
+		WriteBE32(out + 8, height);
+		out[12] = (unsigned char)channels;
+		out[13] = 0;
+		out += 14;
+
+		struct RGBA {
+			unsigned char r_, g_, b_, a_;
+			bool operator==(const RGBA& rhs) const { return r_ == rhs.r_ && g_ == rhs.g_ && b_ == rhs.b_ && a_ == rhs.a_; }
+		};
+		RGBA index[64];
+		memset(index, 0, sizeof(index));
+		RGBA previous = { 0, 0, 0, 255 };
+		unsigned run = 0;
+
+		const unsigned char* in = pixels;
+		for (unsigned i = 0; i < numPixels; ++i, in += components)
+		{
+			RGBA px;
+			switch (components)
+			{
+			case 1:
+				px.r_ = px.g_ = px.b_ = in[0];
+				px.a_ = 255;
+				break;
+			case 2:
+				px.r_ = px.g_ = px.b_ = in[0];
+				px.a_ = in[1];
+				break;
+			case 3:
+				px.r_ = in[0];
+				px.g_ = in[1];
+				px.b_ = in[2];
+				px.a_ = 255;
+				break;
+			default:
+				px.r_ = in[0];
+				px.g_ = in[1];
+				px.b_ = in[2];
+				px.a_ = in[3];
+				break;
+			}
+
+			if (px == previous)
+			{
+				++run;
+				if (run == 62 || i == numPixels - 1)
+				{
+					*out++ = (unsigned char)(0xc0 | (run - 1));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run)
+			{
+				*out++ = (unsigned char)(0xc0 | (run - 1));
+				run = 0;
+			}
+
+			const unsigned hash = (px.r_ * 3 + px.g_ * 5 + px.b_ * 7 + px.a_ * 11) & 63;
+			if (index[hash] == px)
+				*out++ = (unsigned char)hash;
+			else
+			{
+				index[hash] = px;
+				if (px.a_ == previous.a_)
+				{
+					const signed char vr = (signed char)(px.r_ - previous.r_);
+					const signed char vg = (signed char)(px.g_ - previous.g_);
+					const signed char vb = (signed char)(px.b_ - previous.b_);
+					const int vgr = vr - vg;
+					const int vgb = vb - vg;
+					if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+						*out++ = (unsigned char)(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+					else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8)
+					{
+						*out++ = (unsigned char)(0x80 | (vg + 32));
+						*out++ = (unsigned char)((vgr + 8) << 4 | (vgb + 8));
+					}
+					else
+					{
+						*out++ = 0xfe;
+						*out++ = px.r_;
+						*out++ = px.g_;
+						*out++ = px.b_;
+					}
+				}
+				else
+				{
+					*out++ = 0xff;
+					*out++ = px.r_;
+					*out++ = px.g_;
+					*out++ = px.b_;
+					*out++ = px.a_;
+				}
+			}
+			previous = px;
+		}
+
+		static const unsigned char END_MARKER[] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+		memcpy(out, END_MARKER, 8);
+		out += 8;
+		dest.Resize((unsigned)(out - &dest[0]));
+		return true;
+	}
+
+	static bool EncodeBMP(const unsigned char* pixels, unsigned width, unsigned height, unsigned components, PODVector<unsigned char>& dest)
+	{
+		// 32-bit with a V4 header when there's alpha so browsers honour it, 24-bit otherwise
+		const bool alpha = components == 2 || components == 4;
+		const unsigned bytesPerPixel = alpha ? 4 : 3;
+		const unsigned rowSize = (width * bytesPerPixel + 3) & ~3u;
+		const unsigned infoSize = alpha ? 108 : 40;
+		const unsigned dataOffset = 14 + infoSize;
+		dest.Resize(dataOffset + rowSize * height);
+		unsigned char* out = &dest[0];
+		memset(out, 0, dataOffset);
+
+		out[0] = 'B';
+		out[1] = 'M';
+		WriteLE32(out + 2, dest.Size());
+		WriteLE32(out + 10, dataOffset);
+		WriteLE32(out + 14, infoSize);
+		WriteLE32(out + 18, width);
+		// negative height is top-down, no flipping needed
+		WriteLE32(out + 22, (unsigned)-(int)height);
+		WriteLE16(out + 26, 1);
+		WriteLE16(out + 28, bytesPerPixel * 8);
+		WriteLE32(out + 30, alpha ? 3 : 0);
+		WriteLE32(out + 34, rowSize * height);
+		if (alpha)
+		{
+			WriteLE32(out + 54, 0x00ff0000);
+			WriteLE32(out + 58, 0x0000ff00);
+			WriteLE32(out + 62, 0x000000ff);
+			WriteLE32(out + 66, 0xff000000);
+			// LCS_sRGB
+			WriteLE32(out + 70, 0x73524742);
+		}
+
+		for (unsigned y = 0; y < height; ++y)
+		{
+			const unsigned char* in = pixels + y * width * components;
+			unsigned char* row = out + dataOffset + y * rowSize;
+			for (unsigned x = 0; x < width; ++x, in += components, row += bytesPerPixel)
+			{
+				if (components <= 2)
+					row[0] = row[1] = row[2] = in[0];
+				else
+				{
+					row[0] = in[2];
+					row[1] = in[1];
+					row[2] = in[0];
+				}
+				if (alpha)
+					row[3] = in[components - 1];
+			}
+			// zero the row padding
+			for (unsigned i = width * bytesPerPixel; i < rowSize; ++i)
+				out[dataOffset + y * rowSize + i] = 0;
+		}
+		return true;
+	}
+
+	bool EncodeImage(const unsigned char* pixels, unsigned width, unsigned height, unsigned components, DevImageFormat format, int level, PODVector<unsigned char>& dest)
+	{
+		if (!pixels || !width || !height || components < 1 || components > 4)
+			return false;
+
+		switch (format)
+		{
+		case DIF_QOI:
+			return EncodeQOI(pixels, width, height, components, dest);
+		case DIF_BMP:
+			return EncodeBMP(pixels, width, height, components, dest);
+		case DIF_RAW:
+			dest.Resize(width * height * components);
+			memcpy(&dest[0], pixels, dest.Size());
+			return true;
+		default:
+			return EncodePNG(pixels, width, height, components, Clamp(level, 0, 9), dest);
+		}
+	}
+
+	/// Adds a row of bytes into 32-bit column sums, the hot loop of the downsampler.
+	static void AccumulateRow(const unsigned char* row, unsigned count, unsigned* sums)
+	{
+		unsigned i = 0;
+#ifdef DEVIMAGE_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+			const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+			const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+			__m128i* out = reinterpret_cast<__m128i*>(sums + i);
+			_mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), _mm_unpacklo_epi16(low, zero)));
+			_mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(low, zero)));
+			_mm_storeu_si128(out + 2, _mm_add_epi32(_mm_loadu_si128(out + 2), _mm_unpacklo_epi16(high, zero)));
+			_mm_storeu_si128(out + 3, _mm_add_epi32(_mm_loadu_si128(out + 3), _mm_unpackhi_epi16(high, zero)));
+		}
+#endif
+		for (; i < count; ++i)
+			sums[i] += row[i];
+	}
+
+	bool DownsampleImage(const unsigned char* pixels, unsigned width, unsigned height, unsigned components, unsigned maxSize,
+		PODVector<unsigned char>& dest, unsigned& destWidth, unsigned& destHeight)
+	{
+		if (!pixels || !maxSize || (width <= maxSize && height <= maxSize))
+			return false;
+
+		if (width >= height)
+		{
+			destWidth = maxSize;
+			destHeight = Max(1u, (unsigned)((unsigned long long)height * maxSize / width));
+		}
+		else
+		{
+			destHeight = maxSize;
+			destWidth = Max(1u, (unsigned)((unsigned long long)width * maxSize / height));
+		}
+
+		// source column where each output column starts, the boxes differ in width by at most one pixel
+		PODVector<unsigned> columnStart(destWidth + 1);
+		for (unsigned x = 0; x <= destWidth; ++x)
+			columnStart[x] = (unsigned)((unsigned long long)x * width / destWidth);
+
+		const unsigned stride = width * components;
+		PODVector<unsigned> sums(stride);
+		dest.Resize(destWidth * destHeight * components);
+		unsigned char* out = dest.Buffer();
+		for (unsigned y = 0; y < destHeight; ++y)
+		{
+			// sum the band of source rows vertically, then collapse each box horizontally
+			const unsigned y0 = (unsigned)((unsigned long long)y * height / destHeight);
+			const unsigned y1 = (unsigned)((unsigned long long)(y + 1) * height / destHeight);
+			memset(sums.Buffer(), 0, stride * sizeof(unsigned));
+			for (unsigned sy = y0; sy < y1; ++sy)
+				AccumulateRow(pixels + sy * stride, stride, sums.Buffer());
+
+			for (unsigned x = 0; x < destWidth; ++x)
+			{
+				const unsigned x0 = columnStart[x];
+				const unsigned x1 = columnStart[x + 1];
+				const unsigned area = (x1 - x0) * (y1 - y0);
+				for (unsigned c = 0; c < components; ++c)
+				{
+					unsigned total = 0;
+					for (unsigned sx = x0; sx < x1; ++sx)
+						total += sums[sx * components + c];
+					*out++ = (unsigned char)((total + area / 2) / area);
+				}
+			}
+		}
+		return true;
+	}
+
+	/// Block rows below which decompression isn't worth another thread.
+	static const unsigned MIN_BAND_BLOCK_ROWS = 16;
+
+	/// Decompresses a level to RGBA, splitting DXT and ETC1 into bands of block rows decoded in parallel.
+	/// PVRTC blocks blend with their neighbours so it's decoded in one piece.
+	static bool DecompressLevel(const CompressedLevel& level, unsigned char* dest)
+	{
+		const bool bandable = level.format_ == CF_DXT1 || level.format_ == CF_DXT3 || level.format_ == CF_DXT5 || level.format_ == CF_ETC1;
+		const unsigned blockRows = (unsigned)(level.height_ + 3) / 4;
+		const unsigned hardwareThreads = Max(1u, std::thread::hardware_concurrency());
+		const unsigned numBands = bandable ? Clamp(blockRows / MIN_BAND_BLOCK_ROWS, 1u, hardwareThreads) : 1;
+		if (numBands == 1)
+		{
+			CompressedLevel slice = level;
+			slice.depth_ = 1;
+			return slice.Decompress(dest);
+		}
+
+		// each band is a level of its own starting at its first block row
+		Vector<CompressedLevel> bands(numBands);
+		for (unsigned i = 0; i < numBands; ++i)
+		{
+			const unsigned firstRow = blockRows * i / numBands;
+			const unsigned endRow = blockRows * (i + 1) / numBands;
+			CompressedLevel& band = bands[i];
+			band = level;
+			band.data_ = level.data_ + firstRow * level.rowSize_;
+			band.height_ = Min((int)(endRow * 4), level.height_) - (int)(firstRow * 4);
+			band.depth_ = 1;
+			band.rows_ = endRow - firstRow;
+			band.dataSize_ = band.rows_ * level.rowSize_;
+		}
+
+		const unsigned destRowSize = (unsigned)level.width_ * 4;
+		PODVector<unsigned char> results(numBands);
+		std::vector<std::thread> workers;
+		workers.reserve(numBands - 1);
+		for (unsigned i = 1; i < numBands; ++i)
+		{
+			unsigned char* bandDest = dest + blockRows * i / numBands * 4 * destRowSize;
+			workers.push_back(std::thread([&bands, &results, i, bandDest] { results[i] = bands[i].Decompress(bandDest); }));
+		}
+		results[0] = bands[0].Decompress(dest);
+		for (auto& worker : workers)
+			worker.join();
+
+		for (unsigned i = 0; i < numBands; ++i)
+		{
+			if (!results[i])
+				return false;
+		}
+		return true;
+	}
+
+	bool GetImagePreview(const Image* image, DevImagePreview& preview)
+	{
+		if (!image || image->GetWidth() <= 0 || image->GetHeight() <= 0)
+			return false;
+
+		preview.width_ = (unsigned)image->GetWidth();
+		preview.height_ = (unsigned)image->GetHeight();
+		if (!image->IsCompressed())
+		{
+			preview.pixels_ = image->GetData();
+			preview.components_ = image->GetComponents();
+			preview.storage_.Clear();
+			return preview.pixels_ && preview.components_ >= 1 && preview.components_ <= 4;
+		}
+
+		const CompressedLevel level = image->GetCompressedLevel(0);
+		if (!level.data_)
+			return false;
+		preview.components_ = 4;
+		preview.storage_.Resize(preview.width_ * preview.height_ * 4);
+		if (!DecompressLevel(level, preview.storage_.Buffer()))
+			return false;
+		preview.pixels_ = preview.storage_.Buffer();
+		return true;
+	}
+
+	void ConvertFloatPreview(const float* pixels, unsigned width, unsigned height, unsigned components, PODVector<unsigned char>& dest)
+	{
+		const unsigned count = width * height * components;
+		dest.Resize(count);
+		if (!count)
+			return;
+
+		const bool hasAlpha = components == 2 || components == 4;
+		const unsigned colorChannels = hasAlpha ? components - 1 : components;
+
+		// find the range of the colour channels, ignoring NaN and infinities
+		float low = M_INFINITY;
+		float high = -M_INFINITY;
+		for (unsigned i = 0; i < count; ++i)
+		{
+			if (hasAlpha && i % components == colorChannels)
+				continue;
+			const float value = pixels[i];
+			if (std::isfinite(value))
+			{
+				low = Min(low, value);
+				high = Max(high, value);
+			}
+		}
+		if (low > high)
+			low = high = 0.0f;
+
+		// single channel data has no meaningful scale, stretch it so any detail is visible
+		const bool normalize = colorChannels == 1 || low < 0.0f;
+		const bool toneMap = !normalize && high > 1.0f;
+		const float scale = high > low ? 1.0f / (high - low) : 0.0f;
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			float value = pixels[i];
+			if (!std::isfinite(value))
+				value = value > 0.0f ? high : low;
+
+			if (hasAlpha && i % components == colorChannels)
+				value = Clamp(value, 0.0f, 1.0f);
+			else if (normalize)
+				value = (value - low) * scale;
+			else if (toneMap)
+				value = powf(value / (1.0f + value), 1.0f / 2.2f);
+			else
+				value = Clamp(value, 0.0f, 1.0f);
+			dest[i] = (unsigned char)(value * 255.0f + 0.5f);
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../Container/PODVector.h"
+#include "../Container/Str.h"
+
+namespace Urho3D
+{
+	class Image;
+
+	/// Formats images can be downloaded in, picked with ?fmt=.
+	enum DevImageFormat {
+		/// Compressed with ?level= 0-9, 0 writes stored deflate blocks and is nearly as fast as raw.
+		DIF_PNG = 0,
+		/// The Quite OK Image format, lossless and an order of magnitude faster than PNG.
+		DIF_QOI,
+		/// Uncompressed BGR(A).
+		DIF_BMP,
+		/// The pixels as stored, the layout is sent in X-Image-* headers.
+		DIF_RAW
+	};
+
+	/// PNG level used when none is asked for.
+	static const int DEFAULT_IMAGE_LEVEL = 6;
+
+	/// Parses a ?fmt= value, unknown names give defaultFormat.
+	URHO3D_API DevImageFormat ParseImageFormat(const String& name, DevImageFormat defaultFormat = DIF_PNG);
+	/// Short name of the format, as accepted by ParseImageFormat.
+	URHO3D_API const char* GetImageFormatName(DevImageFormat format);
+	/// Content-Type for the format.
+	URHO3D_API const char* GetImageMimeType(DevImageFormat format);
+
+	/// 8-bit pixels an Image can be encoded from.
+	struct URHO3D_API DevImagePreview {
+		DevImagePreview() : pixels_(nullptr), width_(0), height_(0), components_(0) { }
+
+		const unsigned char* pixels_;
+		unsigned width_;
+		unsigned height_;
+		unsigned components_;
+		/// Decompressed or converted pixels, empty when pixels_ points straight into the image.
+		PODVector<unsigned char> storage_;
+	};
+
+	/// Fills preview with the image's first slice as 8-bit pixels, block-compressed images are decompressed to RGBA across worker threads.
+	URHO3D_API bool GetImagePreview(const Image* image, DevImagePreview& preview);
+	/// Converts float pixels to a viewable 8-bit preview: one and two channel data (depth, heights, masks) is normalised to its own range,
+	/// colour is Reinhard tone-mapped and gamma corrected when it exceeds 1, and alpha is clamped.
+	URHO3D_API void ConvertFloatPreview(const float* pixels, unsigned width, unsigned height, unsigned components, PODVector<unsigned char>& dest);
+
+	/// Box-filters 8-bit pixels down to fit within maxSize x maxSize, keeping the aspect ratio.
+	/// Returns false (leaving dest untouched) when the image already fits.
+	URHO3D_API bool DownsampleImage(const unsigned char* pixels, unsigned width, unsigned height, unsigned components, unsigned maxSize,
+		PODVector<unsigned char>& dest, unsigned& destWidth, unsigned& destHeight);
+
+	/// Encodes 8-bit pixels with 1-4 components (gray, gray+alpha, RGB, RGBA) into dest, level only matters for PNG.
+	URHO3D_API bool EncodeImage(const unsigned char* pixels, unsigned width, unsigned height, unsigned components, DevImageFormat format, int level, PODVector<unsigned char>& dest);
+}
@@ -0,0 +1,206 @@
+#include "DevServerJSON.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace Urho3D
+{
+
+	DevServerJSONWriter::DevServerJSONWriter(unsigned reserve) :
+		afterKey_(false)
+	{
+		if (reserve)
+			buffer_.Reserve(reserve);
+	}
+
+	void DevServerJSONWriter::Separate()
+	{
+		if (afterKey_)
+		{
+			afterKey_ = false;
+			return;
+		}
+		if (!first_.Empty())
+		{
+			if (!first_.Back())
+				buffer_ += ',';
+			first_.Back() = false;
+		}
+	}
+
+	void DevServerJSONWriter::BeginObject()
+	{
+		Separate();
+		buffer_ += '{';
+		first_.Push(true);
+	}
+
+	void DevServerJSONWriter::EndObject()
+	{
+		buffer_ += '}';
+		if (!first_.Empty())
+			first_.Pop();
+	}
+
+	void DevServerJSONWriter::BeginArray()
+	{
+		Separate();
+		buffer_ += '[';
+		first_.Push(true);
+	}
+
+	void DevServerJSONWriter::EndArray()
+	{
+		buffer_ += ']';
+		if (!first_.Empty())
+			first_.Pop();
+	}
+
+	void DevServerJSONWriter::Key(const char* key)
+	{
+		Separate();
+		WriteString(key, (unsigned)strlen(key));
+		buffer_ += ':';
+		afterKey_ = true;
+	}
+
+	void DevServerJSONWriter::Key(const String& key)
+	{
+		Separate();
+		WriteString(key.CString(), key.Length());
+		buffer_ += ':';
+		afterKey_ = true;
+	}
+
+	void DevServerJSONWriter::Value(const String& value)
+	{
+		Separate();
+		WriteString(value.CString(), value.Length());
+	}
+
+	void DevServerJSONWriter::Value(const char* value)
+	{
+		Separate();
+		WriteString(value, (unsigned)strlen(value));
+	}
+
+	void DevServerJSONWriter::Value(bool value)
+	{
+		Separate();
+		buffer_ += value ? "true" : "false";
+	}
+
+	void DevServerJSONWriter::Value(int value)
+	{
+		Separate();
+		char temp[16];
+		buffer_.Append(temp, (unsigned)snprintf(temp, sizeof(temp), "%d", value));
+	}
+
+	void DevServerJSONWriter::Value(unsigned value)
+	{
+		Separate();
+		char temp[16];
+		buffer_.Append(temp, (unsigned)snprintf(temp, sizeof(temp), "%u", value));
+	}
+
+	void DevServerJSONWriter::Value(long long value)
+	{
+		Separate();
+		char temp[32];
+		buffer_.Append(temp, (unsigned)snprintf(temp, sizeof(temp), "%lld", value));
+	}
+
+	void DevServerJSONWriter::Value(unsigned long long value)
+	{
+		Separate();
+		char temp[32];
+		buffer_.Append(temp, (unsigned)snprintf(temp, sizeof(temp), "%llu", value));
+	}
+
+	void DevServerJSONWriter::Value(float value)
+	{
+		Value((double)value);
+	}
+
+	void DevServerJSONWriter::Value(double value)
+	{
+		// JSON has no representation for nan/inf
+		if (std::isnan(value) || std::isinf(value))
+		{
+			Null();
+			return;
+		}
+		Separate();
+		char temp[32];
+		buffer_.Append(temp, (unsigned)snprintf(temp, sizeof(temp), "%.9g", value));
+	}
+
+	void DevServerJSONWriter::Null()
+	{
+		Separate();
+		buffer_ += "null";
+	}
+
+	void DevServerJSONWriter::Raw(const char* json)
+	{
+		Separate();
+		buffer_ += json;
+	}
+
+	String DevServerJSONWriter::Detach()
+	{
+		String ret;
+		ret.Swap(buffer_);
+		first_.Clear();
+		afterKey_ = false;
+		return ret;
+	}
+
+	void DevServerJSONWriter::WriteString(const char* str, unsigned length)
+	{
+		static const char hex[] = "0123456789abcdef";
+
+		buffer_ += '"';
+		unsigned runStart = 0;
+		for (unsigned i = 0; i < length; ++i)
+		{
+			const unsigned char c = (unsigned char)str[i];
+			if (c >= 0x20 && c != '"' && c != '\\')
+				continue;
+
+			// copy the clean run in one go
+			if (i > runStart)
+				buffer_.Append(str + runStart, i - runStart);
+			runStart = i + 1;
+
+			switch (c)
+			{
+			case '"':
+				buffer_ += "\\\"";
+				break;
+			case '\\':
+				buffer_ += "\\\\";
+				break;
+			case '\n':
+				buffer_ += "\\n";
+				break;
+			case '\r':
+				buffer_ += "\\r";
+				break;
+			case '\t':
+				buffer_ += "\\t";
+				break;
+			default:
+				{
+					char escaped[7] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf], 0 };
+					buffer_ += escaped;
+				}
+			}
+		}
+		if (length > runStart)
+			buffer_.Append(str + runStart, length - runStart);
+		buffer_ += '"';
+	}
+}
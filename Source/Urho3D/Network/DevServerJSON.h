@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../Container/PODVector.h"
+#include "../Container/Str.h"
+
+namespace Urho3D
+{
+
+	/// Minimal streaming JSON writer that appends straight into one growing String, commas and escaping are handled for you.
+	/// Calls are expected to be well-formed (ie. Key before every value inside an object), nothing is validated.
+	class URHO3D_API DevServerJSONWriter
+	{
+	public:
+		DevServerJSONWriter(unsigned reserve = 0);
+
+		void BeginObject();
+		void EndObject();
+		void BeginArray();
+		void EndArray();
+		/// Writes an object key, the next call writes its value.
+		void Key(const char* key);
+		void Key(const String& key);
+
+		void Value(const String& value);
+		void Value(const char* value);
+		void Value(bool value);
+		void Value(int value);
+		void Value(unsigned value);
+		void Value(long long value);
+		void Value(unsigned long long value);
+		void Value(float value);
+		void Value(double value);
+		void Null();
+		/// Writes pre-formatted JSON as a value.
+		void Raw(const char* json);
+
+		/// Returns the text written so far.
+		const String& GetBuffer() const { return buffer_; }
+		/// Moves the text out, leaving the writer empty.
+		String Detach();
+
+	private:
+		/// Emits the separator for a new value in the current container.
+		void Separate();
+		void WriteString(const char* str, unsigned length);
+
+		String buffer_;
+		/// Per open container: true until its first element has been written.
+		PODVector<bool> first_;
+		/// A key was just written, so the value needs no separator.
+		bool afterKey_;
+	};
+}
@@ -0,0 +1,94 @@
+#include "DevServerLog.h"
+
+#include "../Math/MathDefs.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+	DevServerLogRing::DevServerLogRing(unsigned capacity) :
+		capacity_(Max(capacity, 1u)),
+		head_(0)
+	{
+		slots_ = new Slot[capacity_];
+		for (unsigned i = 0; i < capacity_; ++i)
+		{
+			slots_[i].stamp_.store(0, std::memory_order_relaxed);
+			slots_[i].level_ = 0;
+			slots_[i].time_ = 0;
+			slots_[i].length_ = 0;
+		}
+	}
+
+	DevServerLogRing::~DevServerLogRing()
+	{
+		delete[] slots_;
+	}
+
+	void DevServerLogRing::Push(int level, unsigned time, const String& message)
+	{
+		const unsigned long long sequence = head_.load(std::memory_order_relaxed) + 1;
+		Slot& slot = slots_[(sequence - 1) % capacity_];
+
+		// readers seeing 0 (or a stamp that changed under them) discard what they copied
+		slot.stamp_.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		slot.level_ = level;
+		slot.time_ = time;
+		slot.length_ = Min(message.Length(), MESSAGE_CAPACITY - 1);
+		memcpy(slot.text_, message.CString(), slot.length_);
+		slot.text_[slot.length_] = 0;
+
+		slot.stamp_.store(sequence, std::memory_order_release);
+		head_.store(sequence, std::memory_order_release);
+	}
+
+	unsigned long long DevServerLogRing::GetFirstSequence() const
+	{
+		const unsigned long long last = GetLastSequence();
+		return last > capacity_ ? last - capacity_ + 1 : 1;
+	}
+
+	bool DevServerLogRing::Read(unsigned long long sequence, DevServerLogEntry& entry) const
+	{
+		if (sequence == 0)
+			return false;
+
+		const Slot& slot = slots_[(sequence - 1) % capacity_];
+		if (slot.stamp_.load(std::memory_order_acquire) != sequence)
+			return false;
+
+		char text[MESSAGE_CAPACITY];
+		const int level = slot.level_;
+		const unsigned time = slot.time_;
+		const unsigned length = Min(slot.length_, MESSAGE_CAPACITY - 1);
+		memcpy(text, slot.text_, length);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.stamp_.load(std::memory_order_relaxed) != sequence)
+			return false;
+
+		entry.sequence_ = sequence;
+		entry.level_ = level;
+		entry.time_ = time;
+		entry.message_ = String(text, length);
+		return true;
+	}
+
+	unsigned long long DevServerLogRing::ReadSince(unsigned long long since, int minLevel, unsigned limit, Vector<DevServerLogEntry>& entries) const
+	{
+		const unsigned long long last = GetLastSequence();
+		unsigned long long sequence = Max(since + 1, GetFirstSequence());
+		DevServerLogEntry entry;
+		for (; sequence <= last; ++sequence)
+		{
+			if (limit && entries.Size() >= limit)
+				break;
+			if (Read(sequence, entry) && entry.level_ >= minLevel)
+				entries.Push(entry);
+		}
+		return sequence - 1;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../Container/Str.h"
+#include "../Container/Vector.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+	/// A log message read back out of the ring.
+	struct URHO3D_API DevServerLogEntry {
+		/// Monotonic, starting at 1.
+		unsigned long long sequence_;
+		/// Urho3D log level.
+		int level_;
+		/// Seconds since the epoch.
+		unsigned time_;
+		String message_;
+	};
+
+	/// Fixed-capacity ring of structured log messages.
+	/// Single producer: only one thread may Push (the DevServer pushes from the main thread's log event).
+	/// Any number of threads may read concurrently without locking, each slot is guarded by its own sequence stamp
+	/// so a reader racing the producer detects the overwrite and skips the entry instead of blocking it.
+	/// Messages longer than MESSAGE_CAPACITY - 1 characters are truncated.
+	class URHO3D_API DevServerLogRing
+	{
+	public:
+		/// Characters stored per message, including the terminator.
+		static const unsigned MESSAGE_CAPACITY = 512;
+		/// Default number of retained messages.
+		static const unsigned DEFAULT_CAPACITY = 4096;
+
+		DevServerLogRing(unsigned capacity = DEFAULT_CAPACITY);
+		~DevServerLogRing();
+
+		/// Copies a message into the next slot, overwriting the oldest once full. Producer thread only.
+		void Push(int level, unsigned time, const String& message);
+
+		/// Sequence of the newest message, 0 if nothing has been logged.
+		unsigned long long GetLastSequence() const { return head_.load(std::memory_order_acquire); }
+		/// Sequence of the oldest message still retained.
+		unsigned long long GetFirstSequence() const;
+		/// Number of messages retained.
+		unsigned GetCapacity() const { return capacity_; }
+
+		/// Reads one message, returns false if it was never written or has already been overwritten.
+		bool Read(unsigned long long sequence, DevServerLogEntry& entry) const;
+		/// Reads messages after since (oldest first) at or above minLevel, stopping after limit results (0 for no limit).
+		/// Returns the sequence the scan reached, which is the cursor for the next call.
+		unsigned long long ReadSince(unsigned long long since, int minLevel, unsigned limit, Vector<DevServerLogEntry>& entries) const;
+
+	private:
+		struct Slot {
+			/// Sequence held by the slot, 0 while it's being written.
+			std::atomic<unsigned long long> stamp_;
+			int level_;
+			unsigned time_;
+			unsigned length_;
+			char text_[MESSAGE_CAPACITY];
+		};
+
+		Slot* slots_;
+		unsigned capacity_;
+		std::atomic<unsigned long long> head_;
+	};
+}
@@ -0,0 +1,248 @@
+#include "DevServerMetrics.h"
+
+#include "../Core/Timer.h"
+#include "../Math/MathDefs.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+	/// FNV-1a of a channel name, never 0 as that marks an empty table entry.
+	static unsigned HashChannelName(const char* name)
+	{
+		unsigned hash = 2166136261u;
+		for (const unsigned char* c = reinterpret_cast<const unsigned char*>(name); *c; ++c)
+			hash = (hash ^ *c) * 16777619u;
+		return hash ? hash : 1;
+	}
+
+	DevServerMetrics::Channel::Channel(const char* name, DevMetricKind kind) :
+		name_(name),
+		kind_(kind),
+		head_(0),
+		counter_(0)
+	{
+		for (unsigned i = 0; i < CHANNEL_CAPACITY; ++i)
+		{
+			slots_[i].stamp_.store(0, std::memory_order_relaxed);
+			slots_[i].frame_ = 0;
+			slots_[i].time_ = 0;
+			slots_[i].value_ = 0.0f;
+		}
+	}
+
+	DevServerMetrics::DevServerMetrics() :
+		numChannels_(0),
+		frame_(0),
+		frameTime_(0),
+		startTime_(Time::GetSystemTime())
+	{
+		for (unsigned i = 0; i < MAX_CHANNELS * 2; ++i)
+		{
+			table_[i].hash_.store(0, std::memory_order_relaxed);
+			table_[i].channel_.store(nullptr, std::memory_order_relaxed);
+		}
+		for (unsigned i = 0; i < MAX_CHANNELS; ++i)
+			channels_[i] = nullptr;
+	}
+
+	DevServerMetrics::~DevServerMetrics()
+	{
+		const unsigned count = numChannels_.load(std::memory_order_acquire);
+		for (unsigned i = 0; i < count; ++i)
+			delete channels_[i];
+	}
+
+	DevServerMetrics::Channel* DevServerMetrics::GetChannel(const char* name, DevMetricKind kind)
+	{
+		const unsigned hash = HashChannelName(name);
+		const unsigned mask = MAX_CHANNELS * 2 - 1;
+
+		// the table is never more than half full, so a probe always reaches an empty entry
+		for (unsigned i = hash & mask;; i = (i + 1) & mask)
+		{
+			const unsigned found = table_[i].hash_.load(std::memory_order_acquire);
+			if (!found)
+				break;
+			if (found == hash)
+			{
+				Channel* channel = table_[i].channel_.load(std::memory_order_relaxed);
+				if (channel->name_ == name)
+					return channel;
+			}
+		}
+
+		MutexLock lock(createMutex_);
+		unsigned i = hash & mask;
+		for (;; i = (i + 1) & mask)
+		{
+			// another thread may have created it between the probe and the lock
+			const unsigned found = table_[i].hash_.load(std::memory_order_relaxed);
+			if (!found)
+				break;
+			if (found == hash)
+			{
+				Channel* channel = table_[i].channel_.load(std::memory_order_relaxed);
+				if (channel->name_ == name)
+					return channel;
+			}
+		}
+
+		const unsigned count = numChannels_.load(std::memory_order_relaxed);
+		if (count >= MAX_CHANNELS)
+			return nullptr;
+
+		Channel* channel = new Channel(name, kind);
+		channels_[count] = channel;
+		table_[i].channel_.store(channel, std::memory_order_relaxed);
+		table_[i].hash_.store(hash, std::memory_order_release);
+		numChannels_.store(count + 1, std::memory_order_release);
+		return channel;
+	}
+
+	void DevServerMetrics::Push(Channel* channel, float value)
+	{
+		// writers on several threads each claim their own slot
+		const unsigned long long sequence = channel->head_.fetch_add(1, std::memory_order_relaxed) + 1;
+		Slot& slot = channel->slots_[(sequence - 1) & (CHANNEL_CAPACITY - 1)];
+
+		slot.stamp_.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		slot.frame_ = frame_.load(std::memory_order_relaxed);
+		slot.time_ = frameTime_.load(std::memory_order_relaxed);
+		slot.value_ = value;
+
+		slot.stamp_.store(sequence, std::memory_order_release);
+	}
+
+	void DevServerMetrics::PublishValue(const char* name, float value)
+	{
+		if (Channel* channel = GetChannel(name, DMK_VALUE))
+			Push(channel, value);
+	}
+
+	void DevServerMetrics::PublishCounter(const char* name, int delta)
+	{
+		if (Channel* channel = GetChannel(name, DMK_COUNTER))
+			channel->counter_.fetch_add(delta, std::memory_order_relaxed);
+	}
+
+	void DevServerMetrics::BeginFrame()
+	{
+		// counters close out the frame that just ended, then samples move on to the new one
+		const unsigned count = numChannels_.load(std::memory_order_acquire);
+		for (unsigned i = 0; i < count; ++i)
+		{
+			Channel* channel = channels_[i];
+			if (channel->kind_ == DMK_COUNTER)
+				Push(channel, (float)channel->counter_.exchange(0, std::memory_order_relaxed));
+		}
+
+		frame_.fetch_add(1, std::memory_order_relaxed);
+		frameTime_.store(GetTime(), std::memory_order_relaxed);
+	}
+
+	int DevServerMetrics::FindChannel(const String& name) const
+	{
+		const unsigned count = numChannels_.load(std::memory_order_acquire);
+		for (unsigned i = 0; i < count; ++i)
+		{
+			if (channels_[i]->name_ == name)
+				return (int)i;
+		}
+		return -1;
+	}
+
+	const String& DevServerMetrics::GetChannelName(unsigned index) const
+	{
+		return index < GetNumChannels() ? channels_[index]->name_ : String::EMPTY;
+	}
+
+	DevMetricKind DevServerMetrics::GetChannelKind(unsigned index) const
+	{
+		return index < GetNumChannels() ? channels_[index]->kind_ : DMK_VALUE;
+	}
+
+	unsigned long long DevServerMetrics::GetLastSequence(unsigned index) const
+	{
+		return index < GetNumChannels() ? channels_[index]->head_.load(std::memory_order_acquire) : 0;
+	}
+
+	unsigned DevServerMetrics::GetTime() const
+	{
+		return Time::GetSystemTime() - startTime_;
+	}
+
+	unsigned long long DevServerMetrics::ReadSince(unsigned index, unsigned long long since, unsigned windowMs, PODVector<DevMetricSample>& samples) const
+	{
+		if (index >= GetNumChannels())
+			return since;
+
+		const Channel* channel = channels_[index];
+		const unsigned long long last = channel->head_.load(std::memory_order_acquire);
+		const unsigned long long first = last > CHANNEL_CAPACITY ? last - CHANNEL_CAPACITY + 1 : 1;
+		const unsigned now = GetTime();
+
+		samples.Reserve(samples.Size() + (unsigned)(last - Min(last, Max(since, first - 1))));
+		for (unsigned long long sequence = Max(since + 1, first); sequence <= last; ++sequence)
+		{
+			const Slot& slot = channel->slots_[(sequence - 1) & (CHANNEL_CAPACITY - 1)];
+			if (slot.stamp_.load(std::memory_order_acquire) != sequence)
+				continue;
+
+			DevMetricSample sample;
+			sample.sequence_ = sequence;
+			sample.frame_ = slot.frame_;
+			sample.time_ = slot.time_;
+			sample.value_ = slot.value_;
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.stamp_.load(std::memory_order_relaxed) != sequence)
+				continue;
+			if (windowMs && now - sample.time_ > windowMs)
+				continue;
+			samples.Push(sample);
+		}
+		return last;
+	}
+
+	void DevServerMetrics::Decimate(const PODVector<DevMetricSample>& samples, unsigned numBuckets, PODVector<DevMetricBucket>& buckets)
+	{
+		buckets.Clear();
+		if (samples.Empty() || !numBuckets)
+			return;
+
+		const unsigned start = samples.Front().time_;
+		const unsigned span = samples.Back().time_ - start + 1;
+		buckets.Reserve(numBuckets);
+
+		DevMetricBucket bucket;
+		unsigned current = M_MAX_UNSIGNED;
+		double sum = 0.0;
+		for (const auto& sample : samples)
+		{
+			const unsigned index = (unsigned)((unsigned long long)(sample.time_ - start) * numBuckets / span);
+			if (index != current)
+			{
+				if (current != M_MAX_UNSIGNED)
+				{
+					bucket.avg_ = (float)(sum / bucket.count_);
+					buckets.Push(bucket);
+				}
+				current = index;
+				bucket.time_ = start + (unsigned)((unsigned long long)index * span / numBuckets);
+				bucket.count_ = 0;
+				bucket.min_ = bucket.max_ = sample.value_;
+				sum = 0.0;
+			}
+			++bucket.count_;
+			bucket.min_ = Min(bucket.min_, sample.value_);
+			bucket.max_ = Max(bucket.max_, sample.value_);
+			sum += sample.value_;
+		}
+		bucket.avg_ = (float)(sum / bucket.count_);
+		buckets.Push(bucket);
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../Container/Str.h"
+#include "../Container/Vector.h"
+#include "../Core/Mutex.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+	/// How a metrics channel's samples are produced.
+	enum DevMetricKind {
+		/// Each PublishValue is a sample.
+		DMK_VALUE = 0,
+		/// PublishCounter calls are summed over a frame and the total is sampled at the frame boundary.
+		DMK_COUNTER
+	};
+
+	/// A sample read back out of a channel.
+	struct URHO3D_API DevMetricSample {
+		/// Monotonic per channel, starting at 1.
+		unsigned long long sequence_;
+		/// Frame the sample was taken in.
+		unsigned frame_;
+		/// Milliseconds since the metrics were created.
+		unsigned time_;
+		float value_;
+	};
+
+	/// Min/max/average of the samples falling in one slice of a decimated window.
+	struct URHO3D_API DevMetricBucket {
+		/// Start of the bucket, milliseconds since the metrics were created.
+		unsigned time_;
+		unsigned count_;
+		float min_;
+		float max_;
+		float avg_;
+	};
+
+	/// Named numeric time series written from any thread without locking and read by the /Metrics pages.
+	/// Each channel is a fixed ring of samples, writers claim a slot with an atomic increment and stamp it once written,
+	/// readers racing a writer see the stamp change and skip the sample, as DevServerLogRing does.
+	/// Channels are created on first use and live as long as the metrics, looking one up by name is a lock-free probe
+	/// of an open-addressed table; only creating a channel takes a lock.
+	class URHO3D_API DevServerMetrics
+	{
+	public:
+		/// Most channels that can exist, publishing to further names is ignored.
+		static const unsigned MAX_CHANNELS = 256;
+		/// Samples retained per channel, a power of two.
+		static const unsigned CHANNEL_CAPACITY = 4096;
+
+		DevServerMetrics();
+		~DevServerMetrics();
+
+		/// Records a sample of a value channel. Any thread.
+		void PublishValue(const char* name, float value);
+		/// Adds to a counter channel's total for the current frame. Any thread.
+		void PublishCounter(const char* name, int delta);
+		/// Samples the counters and advances the frame number, main thread once per frame.
+		void BeginFrame();
+
+		/// Returns the number of channels.
+		unsigned GetNumChannels() const { return numChannels_.load(std::memory_order_acquire); }
+		/// Returns a channel's index by name, -1 if it doesn't exist.
+		int FindChannel(const String& name) const;
+		/// Returns the name of a channel by index.
+		const String& GetChannelName(unsigned index) const;
+		/// Returns the kind of a channel by index.
+		DevMetricKind GetChannelKind(unsigned index) const;
+		/// Returns the sequence of a channel's newest sample, 0 if it has none.
+		unsigned long long GetLastSequence(unsigned index) const;
+		/// Returns the current frame number.
+		unsigned GetFrame() const { return frame_.load(std::memory_order_relaxed); }
+		/// Returns milliseconds since the metrics were created.
+		unsigned GetTime() const;
+
+		/// Reads a channel's samples after since that are no older than windowMs (0 for all of them), oldest first.
+		/// Returns the sequence the scan reached, which is the cursor for the next call.
+		unsigned long long ReadSince(unsigned index, unsigned long long since, unsigned windowMs, PODVector<DevMetricSample>& samples) const;
+		/// Reduces samples to at most numBuckets equal slices of time with min/max/average, for charting long windows.
+		static void Decimate(const PODVector<DevMetricSample>& samples, unsigned numBuckets, PODVector<DevMetricBucket>& buckets);
+
+	private:
+		struct Slot {
+			/// Sequence held by the slot, 0 while it's being written.
+			std::atomic<unsigned long long> stamp_;
+			unsigned frame_;
+			unsigned time_;
+			float value_;
+		};
+
+		struct Channel {
+			Channel(const char* name, DevMetricKind kind);
+
+			String name_;
+			DevMetricKind kind_;
+			std::atomic<unsigned long long> head_;
+			/// Running total of a counter for the current frame.
+			std::atomic<long long> counter_;
+			Slot slots_[CHANNEL_CAPACITY];
+		};
+
+		/// An open-addressed table entry, the hash is stored after the channel so a probe that sees it sees the channel.
+		struct Entry {
+			std::atomic<unsigned> hash_;
+			std::atomic<Channel*> channel_;
+		};
+
+		/// Finds or creates the channel for a name, null once MAX_CHANNELS exist.
+		Channel* GetChannel(const char* name, DevMetricKind kind);
+		void Push(Channel* channel, float value);
+
+		Entry table_[MAX_CHANNELS * 2];
+		/// Channels in creation order, for listing.
+		Channel* channels_[MAX_CHANNELS];
+		std::atomic<unsigned> numChannels_;
+		std::atomic<unsigned> frame_;
+		std::atomic<unsigned> frameTime_;
+		unsigned startTime_;
+		/// Serialises channel creation.
+		Mutex createMutex_;
+	};
+}
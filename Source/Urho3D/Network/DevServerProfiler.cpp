@@ -0,0 +1,176 @@
+#include "DevServerProfiler.h"
+
+#include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Math/MathDefs.h"
+
+namespace Urho3D
+{
+
+	DevServerProfiler::DevServerProfiler(unsigned capacity) :
+		slots_(nullptr),
+		capacity_(Max(capacity, 1u)),
+		head_(0),
+		frame_(0),
+		totalCaptureTime_(0),
+		maxCaptureTime_(0)
+	{
+	}
+
+	DevServerProfiler::~DevServerProfiler()
+	{
+		delete[] slots_.load(std::memory_order_relaxed);
+	}
+
+	unsigned DevServerProfiler::InternName(const char* name)
+	{
+		auto found = nameIndices_.Find(name);
+		if (found != nameIndices_.End())
+			return found->second_;
+
+		// blocks at different places in the tree may share a name, they share an index too
+		MutexLock lock(namesMutex_);
+		unsigned index = names_.IndexOf(String(name));
+		if (index == names_.Size())
+			names_.Push(String(name));
+		nameIndices_[name] = index;
+		return index;
+	}
+
+	void DevServerProfiler::Capture(Profiler* profiler)
+	{
+		const ProfilerBlock* root = profiler ? profiler->GetRootBlock() : nullptr;
+		if (!root)
+			return;
+
+		HiresTimer timer;
+		Slot* slots = slots_.load(std::memory_order_relaxed);
+		if (!slots)
+		{
+			slots = new Slot[capacity_];
+			for (unsigned i = 0; i < capacity_; ++i)
+				slots[i].stamp_.store(0, std::memory_order_relaxed);
+			slots_.store(slots, std::memory_order_release);
+			stack_.Reserve(MAX_NODES);
+		}
+
+		const unsigned long long sequence = head_.load(std::memory_order_relaxed) + 1;
+		Slot& slot = slots[(sequence - 1) % capacity_];
+		slot.stamp_.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		// the blocks hold the frame the profiler just closed, walk them depth first without recursing
+		unsigned numNodes = 0;
+		bool truncated = false;
+		// the root is an untimed container, the frame's own blocks (RunFrame and anything outside it) are its children
+		unsigned frameTime = 0;
+		stack_.Clear();
+		for (unsigned i = root->children_.Size(); i-- > 0;)
+		{
+			const ProfilerBlock* child = root->children_[i];
+			frameTime += (unsigned)child->frameTime_;
+			if (child->frameCount_)
+				stack_.Push(MakePair(child, M_MAX_UNSIGNED));
+		}
+		while (!stack_.Empty())
+		{
+			const Pair<const ProfilerBlock*, unsigned> item = stack_.Back();
+			stack_.Pop();
+			const ProfilerBlock* block = item.first_;
+
+			if (numNodes == MAX_NODES)
+			{
+				truncated = true;
+				break;
+			}
+
+			DevProfilerNode& node = slot.nodes_[numNodes];
+			node.name_ = InternName(block->name_);
+			node.parent_ = item.second_;
+			node.depth_ = item.second_ == M_MAX_UNSIGNED ? 0 : slot.nodes_[item.second_].depth_ + 1;
+			node.count_ = block->frameCount_;
+			node.time_ = (unsigned)block->frameTime_;
+			const unsigned index = numNodes++;
+
+			// pushed in reverse so children come out in the profiler's order, blocks not entered this frame are left out with their subtree
+			for (unsigned i = block->children_.Size(); i-- > 0;)
+			{
+				const ProfilerBlock* child = block->children_[i];
+				if (child->frameCount_)
+					stack_.Push(MakePair(child, index));
+			}
+		}
+
+		slot.frame_ = ++frame_;
+		slot.time_ = frameTime;
+		slot.numNodes_ = numNodes;
+		slot.truncated_ = truncated;
+
+		const unsigned captureTime = (unsigned)timer.GetUSec(false);
+		slot.captureTime_ = captureTime;
+		slot.stamp_.store(sequence, std::memory_order_release);
+		head_.store(sequence, std::memory_order_release);
+
+		totalCaptureTime_.fetch_add(captureTime, std::memory_order_relaxed);
+		if (captureTime > maxCaptureTime_.load(std::memory_order_relaxed))
+			maxCaptureTime_.store(captureTime, std::memory_order_relaxed);
+	}
+
+	unsigned long long DevServerProfiler::GetFirstSequence() const
+	{
+		const unsigned long long last = GetLastSequence();
+		return last > capacity_ ? last - capacity_ + 1 : 1;
+	}
+
+	float DevServerProfiler::GetAverageCaptureTime() const
+	{
+		const unsigned long long captures = GetLastSequence();
+		return captures ? (float)((double)totalCaptureTime_.load(std::memory_order_relaxed) / captures) : 0.0f;
+	}
+
+	bool DevServerProfiler::Read(unsigned long long sequence, DevProfilerFrame& frame, bool withNodes) const
+	{
+		const Slot* slots = slots_.load(std::memory_order_acquire);
+		if (!slots || sequence == 0)
+			return false;
+
+		const Slot& slot = slots[(sequence - 1) % capacity_];
+		if (slot.stamp_.load(std::memory_order_acquire) != sequence)
+			return false;
+
+		frame.sequence_ = sequence;
+		frame.frame_ = slot.frame_;
+		frame.time_ = slot.time_;
+		frame.captureTime_ = slot.captureTime_;
+		frame.truncated_ = slot.truncated_;
+		frame.nodes_.Clear();
+		if (withNodes)
+		{
+			const unsigned numNodes = Min(slot.numNodes_, MAX_NODES);
+			frame.nodes_.Resize(numNodes);
+			for (unsigned i = 0; i < numNodes; ++i)
+				frame.nodes_[i] = slot.nodes_[i];
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot.stamp_.load(std::memory_order_relaxed) == sequence;
+	}
+
+	unsigned long long DevServerProfiler::ReadSince(unsigned long long since, bool withNodes, Vector<DevProfilerFrame>& frames) const
+	{
+		const unsigned long long last = GetLastSequence();
+		DevProfilerFrame frame;
+		for (unsigned long long sequence = Max(since + 1, GetFirstSequence()); sequence <= last; ++sequence)
+		{
+			if (Read(sequence, frame, withNodes))
+				frames.Push(frame);
+		}
+		return last;
+	}
+
+	void DevServerProfiler::GetNames(Vector<String>& names) const
+	{
+		MutexLock lock(namesMutex_);
+		names = names_;
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Container/Str.h"
+#include "../Container/Vector.h"
+#include "../Core/Mutex.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+	class Profiler;
+	class ProfilerBlock;
+
+	/// One profiler block of a captured frame, stored in depth-first order.
+	struct URHO3D_API DevProfilerNode {
+		/// Index into the capture's name table.
+		unsigned name_;
+		/// Index of the parent node, M_MAX_UNSIGNED for a top-level block.
+		unsigned parent_;
+		unsigned depth_;
+		/// Times the block was entered during the frame.
+		unsigned count_;
+		/// Microseconds spent in the block during the frame.
+		unsigned time_;
+	};
+
+	/// A captured frame read back out of the ring.
+	struct URHO3D_API DevProfilerFrame {
+		/// Monotonic, starting at 1.
+		unsigned long long sequence_;
+		/// Frame number as counted by the capture.
+		unsigned frame_;
+		/// Microseconds the whole frame took.
+		unsigned time_;
+		/// Microseconds the capture itself took.
+		unsigned captureTime_;
+		/// The block tree had more than MAX_NODES blocks and was cut short.
+		bool truncated_;
+		PODVector<DevProfilerNode> nodes_;
+	};
+
+	/// Captures the engine Profiler's block tree once per frame into a preallocated ring of the last frames.
+	/// The capture runs on the main thread right after the profiler closes a frame, copies each block's frame time and call count,
+	/// and never allocates once the ring exists and every block name has been seen.
+	/// Request threads read frames without locking, each slot is stamped as in DevServerLogRing.
+	class URHO3D_API DevServerProfiler
+	{
+	public:
+		/// Default number of frames retained.
+		static const unsigned DEFAULT_CAPACITY = 300;
+		/// Most blocks captured per frame.
+		static const unsigned MAX_NODES = 512;
+
+		DevServerProfiler(unsigned capacity = DEFAULT_CAPACITY);
+		~DevServerProfiler();
+
+		/// Copies the profiler's last completed frame into the ring. Main thread only.
+		void Capture(Profiler* profiler);
+
+		/// Sequence of the newest frame, 0 if nothing has been captured.
+		unsigned long long GetLastSequence() const { return head_.load(std::memory_order_acquire); }
+		/// Sequence of the oldest frame still retained.
+		unsigned long long GetFirstSequence() const;
+		/// Number of frames retained.
+		unsigned GetCapacity() const { return capacity_; }
+		/// Average microseconds a capture takes.
+		float GetAverageCaptureTime() const;
+		/// Longest capture in microseconds.
+		unsigned GetMaxCaptureTime() const { return maxCaptureTime_.load(std::memory_order_relaxed); }
+
+		/// Reads one frame, with its blocks when withNodes is set. Returns false if it was never captured or has been overwritten.
+		bool Read(unsigned long long sequence, DevProfilerFrame& frame, bool withNodes) const;
+		/// Reads the frames after since, oldest first. Returns the sequence the scan reached.
+		unsigned long long ReadSince(unsigned long long since, bool withNodes, Vector<DevProfilerFrame>& frames) const;
+		/// Copies the block name table, node name_ fields index into it.
+		void GetNames(Vector<String>& names) const;
+
+	private:
+		struct Slot {
+			/// Sequence held by the slot, 0 while it's being written.
+			std::atomic<unsigned long long> stamp_;
+			unsigned frame_;
+			unsigned time_;
+			unsigned captureTime_;
+			unsigned numNodes_;
+			bool truncated_;
+			DevProfilerNode nodes_[MAX_NODES];
+		};
+
+		/// Returns the name table index of a block name, adding it on first sight.
+		unsigned InternName(const char* name);
+
+		/// Allocated on the first capture so a server without a profiler doesn't pay for it.
+		std::atomic<Slot*> slots_;
+		unsigned capacity_;
+		std::atomic<unsigned long long> head_;
+		unsigned frame_;
+		/// Block names by their (stable) pointer, main thread only.
+		HashMap<const char*, unsigned> nameIndices_;
+		/// Block names by index, appended by the main thread and read by requests.
+		Vector<String> names_;
+		mutable Mutex namesMutex_;
+		/// Depth-first traversal stack, kept to avoid allocating per frame.
+		PODVector<Pair<const ProfilerBlock*, unsigned> > stack_;
+		std::atomic<unsigned long long> totalCaptureTime_;
+		std::atomic<unsigned> maxCaptureTime_;
+	};
+}
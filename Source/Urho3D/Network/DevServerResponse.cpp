@@ -0,0 +1,234 @@
+#include "DevServerResponse.h"
+
+#include "../Core/Timer.h"
+#include "../Math/MathDefs.h"
+
+#include <Civetweb/civetweb.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+namespace Urho3D
+{
+
+	/// Reason phrase for the status codes handlers use.
+	static const char* GetStatusText(int status)
+	{
+		switch (status)
+		{
+		case 200: return "OK";
+		case 400: return "Bad Request";
+		case 404: return "Not Found";
+		case 500: return "Internal Server Error";
+		case 503: return "Service Unavailable";
+		default: return "";
+		}
+	}
+
+	DevServerResponse::DevServerResponse(struct mg_connection* conn, unsigned chunkSize) :
+		conn_(conn),
+		chunkSize_(Max(chunkSize, 1024u)),
+		contentType_("text/html"),
+		status_(200),
+		contentLength_(-1),
+		bodySize_(0),
+		sentSize_(0),
+		encoding_(DSE_IDENTITY),
+		appliedEncoding_(DSE_IDENTITY),
+		compressionThreshold_(0),
+		compressionLimit_(0),
+		compressionQuality_(0),
+		compressionTime_(0),
+		writeTime_(0),
+		compressing_(false),
+		compressionChecked_(false),
+		allowChunked_(true),
+		chunked_(false),
+		headersSent_(false),
+		finished_(false),
+		failed_(false)
+	{
+		// chunked encoding only exists from HTTP/1.1 onwards
+		auto requestInfo = mg_get_request_info(conn);
+		if (requestInfo && requestInfo->http_version && strcmp(requestInfo->http_version, "1.0") == 0)
+			allowChunked_ = false;
+		buffer_.Reserve(chunkSize_);
+	}
+
+	DevServerResponse::~DevServerResponse()
+	{
+		Finish();
+	}
+
+	void DevServerResponse::AddHeader(const String& name, const String& value)
+	{
+		headers_ += name + ": " + value + "\r\n";
+	}
+
+	void DevServerResponse::EnableCompression(DevServerEncoding encoding, unsigned threshold, int quality, unsigned limit)
+	{
+		if (headersSent_ || bodySize_ > 0)
+			return;
+		encoding_ = encoding;
+		compressionThreshold_ = threshold;
+		compressionQuality_ = quality;
+		compressionLimit_ = limit;
+		compressing_ = encoding != DSE_IDENTITY;
+	}
+
+	DevServerResponse& DevServerResponse::operator+=(const char* text)
+	{
+		Write(text, (unsigned)strlen(text));
+		return *this;
+	}
+
+	const char* DevServerResponse::GetRequestHeader(const char* name) const
+	{
+		return conn_ ? mg_get_header(conn_, name) : nullptr;
+	}
+
+	void DevServerResponse::Write(const void* data, unsigned size)
+	{
+		if (finished_ || size == 0)
+			return;
+		bodySize_ += size;
+
+		// content type is known by the first write
+		if (compressing_ && !compressionChecked_)
+		{
+			compressionChecked_ = true;
+			compressing_ = IsCompressibleType(contentType_);
+		}
+		if (compressing_)
+		{
+			if (buffer_.Size() + size <= compressionLimit_)
+			{
+				const unsigned offset = buffer_.Size();
+				buffer_.Resize(offset + size);
+				memcpy(&buffer_[offset], data, size);
+				return;
+			}
+			compressing_ = false;
+		}
+
+		if (buffer_.Size() + size > chunkSize_)
+		{
+			Flush();
+			// big writes go straight out as their own chunk instead of being copied through the buffer
+			if (size >= chunkSize_)
+			{
+				SendBody(data, size);
+				return;
+			}
+		}
+
+		const unsigned offset = buffer_.Size();
+		buffer_.Resize(offset + size);
+		memcpy(&buffer_[offset], data, size);
+	}
+
+	void DevServerResponse::Flush()
+	{
+		if (finished_ || compressing_ || buffer_.Empty())
+			return;
+		if (!headersSent_)
+			SendHeaders(contentLength_ < 0 && allowChunked_);
+		SendBody(&buffer_[0], buffer_.Size());
+		buffer_.Clear();
+	}
+
+	void DevServerResponse::Finish()
+	{
+		if (finished_)
+			return;
+
+		if (compressing_ && !headersSent_ && buffer_.Size() >= compressionThreshold_)
+		{
+			HiresTimer timer;
+			PODVector<unsigned char> encoded;
+			const bool compressed = CompressBuffer(&buffer_[0], buffer_.Size(), encoding_, compressionQuality_, encoded);
+			compressionTime_ = timer.GetUSec(false);
+			if (compressed)
+			{
+				AddHeader("Content-Encoding", GetEncodingName(encoding_));
+				AddHeader("Vary", "Accept-Encoding");
+				appliedEncoding_ = encoding_;
+				contentLength_ = (int)encoded.Size();
+				SendHeaders(false);
+				SendBody(&encoded[0], encoded.Size());
+				buffer_.Clear();
+				finished_ = true;
+				return;
+			}
+		}
+
+		// nothing has gone out yet so the length is exactly what's buffered
+		if (!headersSent_)
+		{
+			if (contentLength_ < 0)
+				contentLength_ = (int)buffer_.Size();
+			SendHeaders(false);
+		}
+		if (!buffer_.Empty())
+			SendBody(&buffer_[0], buffer_.Size());
+		buffer_.Clear();
+
+		if (chunked_)
+			SendRaw("0\r\n\r\n", 5);
+		finished_ = true;
+	}
+
+	void DevServerResponse::Cancel()
+	{
+		// once headers are out the status is committed and only finishing leaves the connection in a sane state
+		assert(!headersSent_);
+		buffer_.Clear();
+		finished_ = true;
+	}
+
+	void DevServerResponse::SendHeaders(bool chunked)
+	{
+		String head = "HTTP/1.1 " + String(status_) + " " + GetStatusText(status_) + "\r\nContent-Type: " + contentType_ + "\r\n";
+		head += headers_;
+		if (contentLength_ >= 0)
+			head += "Content-Length: " + String(contentLength_) + "\r\n";
+		else if (chunked)
+			head += "Transfer-Encoding: chunked\r\n";
+		else
+			head += "Connection: close\r\n";
+		head += "\r\n";
+
+		chunked_ = chunked;
+		headersSent_ = true;
+		SendRaw(head.CString(), head.Length());
+	}
+
+	void DevServerResponse::SendBody(const void* data, unsigned size)
+	{
+		if (!headersSent_)
+			SendHeaders(contentLength_ < 0 && allowChunked_);
+		sentSize_ += size;
+
+		if (chunked_)
+		{
+			char prefix[16];
+			int prefixLen = snprintf(prefix, sizeof(prefix), "%x\r\n", size);
+			SendRaw(prefix, (unsigned)prefixLen);
+			SendRaw(data, size);
+			SendRaw("\r\n", 2);
+		}
+		else
+			SendRaw(data, size);
+	}
+
+	void DevServerResponse::SendRaw(const void* data, unsigned size)
+	{
+		if (failed_)
+			return;
+		HiresTimer timer;
+		if (mg_write(conn_, data, size) <= 0)
+			failed_ = true;
+		writeTime_ += timer.GetUSec(false);
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "../Container/PODVector.h"
+#include "../Container/Str.h"
+#include "../Network/DevServerCompression.h"
+
+struct mg_connection;
+
+namespace Urho3D
+{
+
+	/// Writer for an HTTP response that handlers append to while they generate it, 200 unless SetStatus says otherwise.
+	/// Output is buffered and flushed to the connection in fixed-size chunks:
+	///		- a response that finishes before the first chunk fills is sent whole with a Content-Length
+	///		- a response with a declared length streams its body as-is
+	///		- otherwise the response switches to HTTP/1.1 chunked transfer encoding on the first flush
+	/// Headers are sent with the first flush, so set content type and headers before writing large bodies.
+	/// With compression enabled compressible bodies are held back until Finish so they can be sent compressed with a length,
+	/// a body that outgrows the compression limit falls back to streaming uncompressed.
+	class URHO3D_API DevServerResponse
+	{
+	public:
+		/// Default size of a flushed chunk.
+		static const unsigned DEFAULT_CHUNK_SIZE = 16 * 1024;
+		/// Default largest body that will be held back for compression.
+		static const unsigned DEFAULT_COMPRESSION_LIMIT = 8 * 1024 * 1024;
+
+		DevServerResponse(struct mg_connection* conn, unsigned chunkSize = DEFAULT_CHUNK_SIZE);
+		/// Finishes the response if the handler didn't.
+		~DevServerResponse();
+
+		/// Sets the status code, 200 by default, must be called before anything is flushed.
+		void SetStatus(int status) { status_ = status; }
+		/// Sets the Content-Type, text/html by default.
+		void SetContentType(const String& mimeType) { contentType_ = mimeType; }
+		/// Declares the body length up front so large bodies can stream without chunk framing.
+		void SetContentLength(unsigned length) { contentLength_ = (int)length; }
+		/// Adds an extra header line (without the CRLF).
+		void AddHeader(const String& name, const String& value);
+		/// Compresses compressible bodies of at least threshold bytes with the given coding, must be called before writing.
+		void EnableCompression(DevServerEncoding encoding, unsigned threshold, int quality, unsigned limit = DEFAULT_COMPRESSION_LIMIT);
+
+		/// Appends body data.
+		void Write(const void* data, unsigned size);
+		void Write(const String& text) { Write(text.CString(), text.Length()); }
+		DevServerResponse& operator+=(const String& text) { Write(text); return *this; }
+		DevServerResponse& operator+=(const char* text);
+
+		/// Sends everything buffered so far, committing to chunked encoding if the length is still unknown.
+		void Flush();
+		/// Completes the response, sending headers and any remaining data.
+		void Finish();
+		/// Drops the response without sending anything so the caller can answer the request another way, only valid before headers go out.
+		void Cancel();
+
+		/// Returns a header of the request being answered, null if it wasn't sent.
+		const char* GetRequestHeader(const char* name) const;
+		/// Returns the status code the response is sent with.
+		int GetStatus() const { return status_; }
+		/// Returns true once headers have been sent.
+		bool HeadersSent() const { return headersSent_; }
+		/// Returns true once the response has been completed.
+		bool IsFinished() const { return finished_; }
+		/// Returns true if a write to the connection failed (ie. the client went away).
+		bool HasFailed() const { return failed_; }
+		/// Body bytes written by the handler.
+		unsigned GetBodySize() const { return bodySize_; }
+		/// Body bytes that went to the connection (after compression, excluding chunk framing).
+		unsigned GetSentSize() const { return sentSize_; }
+		/// Coding the body was actually sent with.
+		DevServerEncoding GetAppliedEncoding() const { return appliedEncoding_; }
+		/// Microseconds spent compressing.
+		long long GetCompressionTime() const { return compressionTime_; }
+		/// Microseconds spent writing to the connection, including waiting on a slow client.
+		long long GetWriteTime() const { return writeTime_; }
+
+	private:
+		void SendHeaders(bool chunked);
+		void SendBody(const void* data, unsigned size);
+		void SendRaw(const void* data, unsigned size);
+
+		struct mg_connection* conn_;
+		PODVector<unsigned char> buffer_;
+		unsigned chunkSize_;
+		String contentType_;
+		String headers_;
+		int status_;
+		int contentLength_;
+		unsigned bodySize_;
+		unsigned sentSize_;
+		/// Compression settings, compressing_ is dropped once the body turns out not to qualify.
+		DevServerEncoding encoding_;
+		DevServerEncoding appliedEncoding_;
+		unsigned compressionThreshold_;
+		unsigned compressionLimit_;
+		int compressionQuality_;
+		long long compressionTime_;
+		long long writeTime_;
+		bool compressing_;
+		bool compressionChecked_;
+		bool allowChunked_;
+		bool chunked_;
+		bool headersSent_;
+		bool finished_;
+		bool failed_;
+	};
+}
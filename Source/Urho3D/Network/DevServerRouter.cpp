@@ -0,0 +1,144 @@
+#include "DevServerRouter.h"
+
+#include "../IO/Log.h"
+#include "../Network/DevServer.h"
+
+namespace Urho3D
+{
+
+	DevServerRouter::RouteNode::RouteNode() :
+		capture_(nullptr)
+	{
+	}
+
+	DevServerRouter::RouteNode::~RouteNode()
+	{
+		for (auto child : literals_)
+			delete child.second_;
+		delete capture_;
+	}
+
+	DevServerRouter::DevServerRouter() :
+		numRegistrations_(0)
+	{
+	}
+
+	DevServerRouter::~DevServerRouter()
+	{
+	}
+
+	void DevServerRouter::Get(const String& pattern, DevServerHandler* handler)
+	{
+		Add(getRoot_, pattern, handler);
+	}
+
+	void DevServerRouter::Post(const String& pattern, DevServerHandler* handler)
+	{
+		Add(postRoot_, pattern, handler);
+	}
+
+	const DevServerRoute* DevServerRouter::MatchGet(const Vector<String>& uri, VariantMap& captures) const
+	{
+		return Match(&getRoot_, uri, captures);
+	}
+
+	const DevServerRoute* DevServerRouter::MatchPost(const Vector<String>& uri, VariantMap& captures) const
+	{
+		return Match(&postRoot_, uri, captures);
+	}
+
+	void DevServerRouter::Add(RouteNode& root, const String& pattern, DevServerHandler* handler)
+	{
+		if (handler == nullptr)
+			return;
+
+		Vector<String> segments = pattern.Split('/');
+		Vector<String> captureNames;
+		RouteNode* node = &root;
+		DevServerRoute* target = nullptr;
+		for (unsigned i = 0; i < segments.Size(); ++i)
+		{
+			const String& seg = segments[i];
+			if (seg.StartsWith("{*") && seg.EndsWith("}"))
+			{
+				if (i != segments.Size() - 1)
+				{
+					URHO3D_LOGERRORF("DevServer route '%s' has a remainder capture that isn't last", pattern.CString());
+					return;
+				}
+				captureNames.Push(seg.Substring(2, seg.Length() - 3));
+				target = &node->tail_;
+				break;
+			}
+			else if (seg.StartsWith("{") && seg.EndsWith("}"))
+			{
+				captureNames.Push(seg.Substring(1, seg.Length() - 2));
+				if (!node->capture_)
+					node->capture_ = new RouteNode();
+				node = node->capture_;
+			}
+			else
+			{
+				const String key = seg.ToLower();
+				auto found = node->literals_.Find(key);
+				if (found == node->literals_.End())
+					found = node->literals_.Insert(MakePair(key, new RouteNode()));
+				node = found->second_;
+			}
+		}
+		if (!target)
+			target = &node->route_;
+
+		if (target->handler_)
+			URHO3D_LOGWARNINGF("DevServer route '%s' replaces '%s'", pattern.CString(), target->pattern_.CString());
+		++numRegistrations_;
+
+		target->handler_ = handler;
+		target->pattern_ = pattern;
+		target->captureNames_ = captureNames;
+	}
+
+	const DevServerRoute* DevServerRouter::Match(const RouteNode* root, const Vector<String>& uri, VariantMap& captures)
+	{
+		Vector<String> values;
+		const DevServerRoute* route = Walk(root, uri, 0, values);
+		if (route)
+		{
+			for (unsigned i = 0; i < route->captureNames_.Size() && i < values.Size(); ++i)
+				captures[route->captureNames_[i]] = values[i];
+		}
+		return route;
+	}
+
+	const DevServerRoute* DevServerRouter::Walk(const RouteNode* node, const Vector<String>& uri, unsigned index, Vector<String>& values)
+	{
+		if (index == uri.Size())
+			return node->route_.handler_ ? &node->route_ : nullptr;
+
+		const String& seg = uri[index];
+		auto found = node->literals_.Find(seg.ToLower());
+		if (found != node->literals_.End())
+		{
+			if (auto route = Walk(found->second_, uri, index + 1, values))
+				return route;
+		}
+
+		if (node->capture_)
+		{
+			values.Push(seg);
+			if (auto route = Walk(node->capture_, uri, index + 1, values))
+				return route;
+			values.Pop();
+		}
+
+		if (node->tail_.handler_)
+		{
+			String remainder = seg;
+			for (unsigned i = index + 1; i < uri.Size(); ++i)
+				remainder += "/" + uri[i];
+			values.Push(remainder);
+			return &node->tail_;
+		}
+		return nullptr;
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Container/Str.h"
+#include "../Core/Variant.h"
+
+namespace Urho3D
+{
+	class DevServer;
+	struct DevServerHandler;
+
+	/// A resolved route, handed back by the router so dispatch never has to poll handlers.
+	struct URHO3D_API DevServerRoute {
+		DevServerRoute() : handler_(nullptr) { }
+
+		/// Handler that registered the pattern.
+		DevServerHandler* handler_;
+		/// Pattern as registered, useful as a stable key for per-endpoint bookkeeping.
+		String pattern_;
+		/// Capture names in the order they appear in the pattern.
+		Vector<String> captureNames_;
+	};
+
+	/// Resolves URIs to handlers through a segment trie.
+	/// Patterns are '/' separated, ie. "Scenes/{scene}/Node/{id}":
+	///		- literal segments compare case-insensitively
+	///		- {name} captures exactly one segment
+	///		- {*name} as the last segment captures all remaining segments (rejoined with '/')
+	/// Captured values are written into the params map as Strings keyed by the capture name.
+	/// Literal segments are preferred over captures when both could match.
+	class URHO3D_API DevServerRouter
+	{
+	public:
+		DevServerRouter();
+		~DevServerRouter();
+
+		/// Registers a pattern for HTTP GET.
+		void Get(const String& pattern, DevServerHandler* handler);
+		/// Registers a pattern for HTTP POST.
+		void Post(const String& pattern, DevServerHandler* handler);
+
+		/// Finds the GET route for the URI, filling captures. Returns null if nothing matched.
+		const DevServerRoute* MatchGet(const Vector<String>& uri, VariantMap& captures) const;
+		/// Finds the POST route for the URI, filling captures. Returns null if nothing matched.
+		const DevServerRoute* MatchPost(const Vector<String>& uri, VariantMap& captures) const;
+
+		/// Number of registrations so far (GET and POST), including ones that replaced an earlier pattern.
+		unsigned GetNumRegistrations() const { return numRegistrations_; }
+
+	private:
+		struct RouteNode {
+			RouteNode();
+			~RouteNode();
+
+			/// Literal children keyed by lower-cased segment.
+			HashMap<String, RouteNode*> literals_;
+			/// Single-segment capture child.
+			RouteNode* capture_;
+			/// Remainder capture, only valid when its handler is set.
+			DevServerRoute tail_;
+			/// Route terminating at this node, only valid when its handler is set.
+			DevServerRoute route_;
+		};
+
+		void Add(RouteNode& root, const String& pattern, DevServerHandler* handler);
+		static const DevServerRoute* Match(const RouteNode* root, const Vector<String>& uri, VariantMap& captures);
+		static const DevServerRoute* Walk(const RouteNode* node, const Vector<String>& uri, unsigned index, Vector<String>& values);
+
+		RouteNode getRoot_;
+		RouteNode postRoot_;
+		unsigned numRegistrations_;
+	};
+}
@@ -0,0 +1,299 @@
+#include "DevServerSearch.h"
+
+#include "../Math/MathDefs.h"
+#include "../Network/DevInspector.h"
+#include "../Scene/Component.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
+
+namespace Urho3D
+{
+
+	/// Three lower-cased characters packed into a key.
+	static unsigned GetTrigram(const String& term, unsigned index)
+	{
+		return ((unsigned)(unsigned char)term[index] << 16) | ((unsigned)(unsigned char)term[index + 1] << 8) | (unsigned char)term[index + 2];
+	}
+
+	/// The first one or two characters of a term packed into a key, the length kept in the top byte.
+	static unsigned GetLead(const String& term, unsigned length)
+	{
+		return length == 1 ? (1u << 24) | (unsigned char)term[0] : (2u << 24) | ((unsigned)(unsigned char)term[0] << 8) | (unsigned char)term[1];
+	}
+
+	/// Shortest substring query Find answers, shorter ones are in too many terms to be worth listing.
+	static const unsigned MIN_SUBSTRING_LENGTH = 3;
+
+	DevSceneIndex::DevSceneIndex(Context* context, Scene* scene) :
+		Object(context),
+		scene_(scene)
+	{
+		if (!scene)
+			return;
+
+		{
+			MutexLock lock(mutex_);
+			AddSubtree(scene);
+		}
+
+		SubscribeToEvent(scene, E_NODEADDED, URHO3D_HANDLER(DevSceneIndex, HandleNodeAdded));
+		SubscribeToEvent(scene, E_NODEREMOVED, URHO3D_HANDLER(DevSceneIndex, HandleNodeRemoved));
+		SubscribeToEvent(scene, E_NODENAMECHANGED, URHO3D_HANDLER(DevSceneIndex, HandleNodeChanged));
+		SubscribeToEvent(scene, E_NODETAGADDED, URHO3D_HANDLER(DevSceneIndex, HandleNodeChanged));
+		SubscribeToEvent(scene, E_NODETAGREMOVED, URHO3D_HANDLER(DevSceneIndex, HandleTagRemoved));
+		SubscribeToEvent(scene, E_COMPONENTADDED, URHO3D_HANDLER(DevSceneIndex, HandleNodeChanged));
+		SubscribeToEvent(scene, E_COMPONENTREMOVED, URHO3D_HANDLER(DevSceneIndex, HandleComponentRemoved));
+	}
+
+	const char* DevSceneIndex::GetFieldName(DevSearchField field)
+	{
+		switch (field)
+		{
+		case DSF_TAG:
+			return "tag";
+		case DSF_VAR:
+			return "variable";
+		case DSF_COMPONENT:
+			return "component";
+		default:
+			return "name";
+		}
+	}
+
+	void DevSceneIndex::HandleNodeAdded(StringHash, VariantMap& eventData)
+	{
+		using namespace NodeAdded;
+		// only the root of an attached subtree is announced
+		MutexLock lock(mutex_);
+		AddSubtree(static_cast<Node*>(eventData[P_NODE].GetPtr()));
+	}
+
+	void DevSceneIndex::HandleNodeRemoved(StringHash, VariantMap& eventData)
+	{
+		using namespace NodeRemoved;
+		// sent while the node still has its children, a node moving within the scene is added straight back
+		MutexLock lock(mutex_);
+		RemoveSubtree(static_cast<Node*>(eventData[P_NODE].GetPtr()));
+	}
+
+	void DevSceneIndex::HandleNodeChanged(StringHash, VariantMap& eventData)
+	{
+		// name, tag and component events all carry the node under the same parameter name
+		using namespace NodeNameChanged;
+		MutexLock lock(mutex_);
+		if (const Node* node = static_cast<Node*>(eventData[P_NODE].GetPtr()))
+			IndexNode(node);
+	}
+
+	void DevSceneIndex::HandleComponentRemoved(StringHash, VariantMap& eventData)
+	{
+		using namespace ComponentRemoved;
+		MutexLock lock(mutex_);
+		if (const Node* node = static_cast<Node*>(eventData[P_NODE].GetPtr()))
+			IndexNode(node, static_cast<Component*>(eventData[P_COMPONENT].GetPtr()));
+	}
+
+	void DevSceneIndex::HandleTagRemoved(StringHash, VariantMap& eventData)
+	{
+		using namespace NodeTagRemoved;
+		MutexLock lock(mutex_);
+		if (const Node* node = static_cast<Node*>(eventData[P_NODE].GetPtr()))
+			IndexNode(node, nullptr, eventData[P_TAG].GetString());
+	}
+
+	void DevSceneIndex::AddSubtree(const Node* node)
+	{
+		WalkNodes(node, [this](const Node* n, unsigned) {
+			IndexNode(n);
+			return true;
+		}, [](const Node*, unsigned) { });
+	}
+
+	void DevSceneIndex::RemoveSubtree(const Node* node)
+	{
+		WalkNodes(node, [this](const Node* n, unsigned) {
+			UnindexNode(n->GetID());
+			return true;
+		}, [](const Node*, unsigned) { });
+	}
+
+	void DevSceneIndex::IndexNode(const Node* node, const Component* excludeComponent, const String& excludeTag)
+	{
+		const unsigned id = node->GetID();
+		UnindexNode(id);
+
+		Entry& entry = nodes_[id];
+		entry.name_ = node->GetName();
+		auto add = [&](const String& text, DevSearchField field) {
+			if (text.Empty())
+				return;
+			const String term = text.ToLower();
+			entry.terms_.Push(MakePair(term, field));
+			AddTerm(term, id);
+		};
+
+		add(node->GetName(), DSF_NAME);
+		for (const auto& tag : node->GetTags())
+		{
+			if (tag != excludeTag)
+				add(tag, DSF_TAG);
+		}
+		// variables are keyed by hash, only the names the scene was told about can be searched for
+		if (Scene* scene = node->GetScene())
+		{
+			for (const auto& var : node->GetVars())
+				add(scene->GetVarName(var.first_), DSF_VAR);
+		}
+		for (const auto& component : node->GetComponents())
+		{
+			if (component.Get() != excludeComponent)
+				add(component->GetTypeName(), DSF_COMPONENT);
+		}
+	}
+
+	void DevSceneIndex::UnindexNode(unsigned id)
+	{
+		auto found = nodes_.Find(id);
+		if (found == nodes_.End())
+			return;
+		for (const auto& term : found->second_.terms_)
+			RemoveTerm(term.first_, id);
+		nodes_.Erase(found);
+	}
+
+	void DevSceneIndex::AddTerm(const String& term, unsigned id)
+	{
+		HashMap<unsigned, unsigned>& postings = postings_[term];
+		if (postings.Empty())
+		{
+			for (unsigned i = 0; i + 3 <= term.Length(); ++i)
+				trigrams_[GetTrigram(term, i)].Insert(term);
+			for (unsigned length = 1; length <= Min(term.Length(), 2u); ++length)
+				leads_[GetLead(term, length)].Insert(term);
+		}
+		++postings[id];
+	}
+
+	void DevSceneIndex::RemoveTerm(const String& term, unsigned id)
+	{
+		auto found = postings_.Find(term);
+		if (found == postings_.End())
+			return;
+		auto posting = found->second_.Find(id);
+		if (posting == found->second_.End())
+			return;
+		if (--posting->second_)
+			return;
+
+		found->second_.Erase(posting);
+		if (!found->second_.Empty())
+			return;
+		for (unsigned i = 0; i + 3 <= term.Length(); ++i)
+		{
+			auto trigram = trigrams_.Find(GetTrigram(term, i));
+			if (trigram == trigrams_.End())
+				continue;
+			trigram->second_.Erase(term);
+			if (trigram->second_.Empty())
+				trigrams_.Erase(trigram);
+		}
+		for (unsigned length = 1; length <= Min(term.Length(), 2u); ++length)
+		{
+			auto lead = leads_.Find(GetLead(term, length));
+			if (lead == leads_.End())
+				continue;
+			lead->second_.Erase(term);
+			if (lead->second_.Empty())
+				leads_.Erase(lead);
+		}
+		postings_.Erase(found);
+	}
+
+	unsigned DevSceneIndex::Find(const String& text, bool prefix, unsigned maxResults, Vector<DevSearchMatch>& matches) const
+	{
+		const String query = text.Trimmed().ToLower();
+		if (query.Empty() || (!prefix && query.Length() < MIN_SUBSTRING_LENGTH))
+			return 0;
+
+		// the candidates are copied out and compared without the lock, the main thread's event handlers only wait for the copy
+		Vector<String> terms;
+		{
+			MutexLock lock(mutex_);
+			const HashSet<String>* candidates = nullptr;
+			if (query.Length() < 3)
+			{
+				auto lead = leads_.Find(GetLead(query, query.Length()));
+				if (lead == leads_.End())
+					return 0;
+				candidates = &lead->second_;
+			}
+			else
+			{
+				// every matching term contains all of the query's trigrams, the rarest one has the fewest terms to check
+				for (unsigned i = 0; i + 3 <= query.Length(); ++i)
+				{
+					auto trigram = trigrams_.Find(GetTrigram(query, i));
+					if (trigram == trigrams_.End())
+						return 0;
+					if (!candidates || trigram->second_.Size() < candidates->Size())
+						candidates = &trigram->second_;
+				}
+			}
+			terms.Reserve(candidates->Size());
+			for (const auto& term : *candidates)
+				terms.Push(term);
+		}
+
+		HashSet<unsigned> found;
+		for (const auto& term : terms)
+		{
+			if (prefix ? !term.StartsWith(query) : !term.Contains(query))
+				continue;
+
+			// relocked per term, an update waits for one term's nodes at most, and one made in between is simply seen or not
+			MutexLock lock(mutex_);
+			auto postings = postings_.Find(term);
+			if (postings == postings_.End())
+				continue;
+			for (const auto& posting : postings->second_)
+			{
+				if (found.Contains(posting.first_))
+					continue;
+				found.Insert(posting.first_);
+				if (matches.Size() >= maxResults)
+					continue;
+
+				auto node = nodes_.Find(posting.first_);
+				DevSearchMatch match;
+				match.id_ = posting.first_;
+				match.field_ = DSF_NAME;
+				if (node != nodes_.End())
+				{
+					match.name_ = node->second_.name_;
+					for (const auto& nodeTerm : node->second_.terms_)
+					{
+						if (nodeTerm.first_ == term)
+						{
+							match.field_ = nodeTerm.second_;
+							break;
+						}
+					}
+				}
+				matches.Push(match);
+			}
+		}
+		return found.Size();
+	}
+
+	unsigned DevSceneIndex::GetNumNodes() const
+	{
+		MutexLock lock(mutex_);
+		return nodes_.Size();
+	}
+
+	unsigned DevSceneIndex::GetNumTerms() const
+	{
+		MutexLock lock(mutex_);
+		return postings_.Size();
+	}
+}
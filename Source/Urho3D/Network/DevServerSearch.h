@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Container/HashSet.h"
+#include "../Container/Ptr.h"
+#include "../Container/Str.h"
+#include "../Core/Mutex.h"
+#include "../Core/Object.h"
+
+namespace Urho3D
+{
+	class Component;
+	class Node;
+	class Scene;
+
+	/// The part of a node a search term was taken from.
+	enum DevSearchField {
+		DSF_NAME = 0,
+		DSF_TAG,
+		DSF_VAR,
+		DSF_COMPONENT
+	};
+
+	/// A node found by DevSceneIndex::Find.
+	struct URHO3D_API DevSearchMatch {
+		unsigned id_;
+		String name_;
+		/// Field of the first term on the node that matched.
+		DevSearchField field_;
+	};
+
+	/// Search index over the node names, tags, variable names and component types of one scene.
+	/// Built with one walk of the scene and then kept current from the scene's node and component events, nodes are reindexed one at a time as they change.
+	/// Terms are lower-cased and looked up through a trigram table, so a substring or prefix query of three or more characters
+	/// only compares the terms sharing the query's rarest trigram. Prefix queries of one or two characters go through a table of the terms'
+	/// leading characters instead, substring queries that short would match most of the scene and find nothing.
+	/// Variables can only be found by name when the name was registered with Scene::RegisterVar, and since setting a variable sends no event
+	/// they're picked up the next time something else about the node changes.
+	/// Events arrive on the main thread, Find may be called from any thread.
+	class URHO3D_API DevSceneIndex : public Object
+	{
+		URHO3D_OBJECT(DevSceneIndex, Object);
+	public:
+		/// Indexes the scene and subscribes to its events. Main thread.
+		DevSceneIndex(Context* context, Scene* scene);
+
+		/// Finds nodes with a term containing text (or starting with it when prefix is set), case-insensitive. Substring queries need three characters.
+		/// Returns the number of matching nodes, of which at most maxResults are added to matches.
+		/// The lock is only held to copy out the candidate terms and then for one term's nodes at a time, so a broad query doesn't stall the scene's events.
+		unsigned Find(const String& text, bool prefix, unsigned maxResults, Vector<DevSearchMatch>& matches) const;
+		/// Returns the number of nodes indexed.
+		unsigned GetNumNodes() const;
+		/// Returns the number of distinct terms.
+		unsigned GetNumTerms() const;
+
+		/// Returns a field's name for display.
+		static const char* GetFieldName(DevSearchField field);
+
+	private:
+		void HandleNodeAdded(StringHash, VariantMap& eventData);
+		void HandleNodeRemoved(StringHash, VariantMap& eventData);
+		void HandleNodeChanged(StringHash, VariantMap& eventData);
+		void HandleComponentRemoved(StringHash, VariantMap& eventData);
+		void HandleTagRemoved(StringHash, VariantMap& eventData);
+
+		/// Indexes a node and everything below it.
+		void AddSubtree(const Node* node);
+		/// Drops a node and everything below it.
+		void RemoveSubtree(const Node* node);
+		/// Replaces a node's terms with its current ones, leaving out a component or tag that's on its way out.
+		void IndexNode(const Node* node, const Component* excludeComponent = nullptr, const String& excludeTag = String::EMPTY);
+		void UnindexNode(unsigned id);
+		void AddTerm(const String& term, unsigned id);
+		void RemoveTerm(const String& term, unsigned id);
+
+		struct Entry {
+			String name_;
+			/// Lower-cased terms with the field they came from, one per occurrence.
+			Vector<Pair<String, DevSearchField> > terms_;
+		};
+
+		WeakPtr<Scene> scene_;
+		HashMap<unsigned, Entry> nodes_;
+		/// Nodes by lower-cased term, with how many times the term occurs on each.
+		HashMap<String, HashMap<unsigned, unsigned> > postings_;
+		/// Terms by the trigrams they contain.
+		HashMap<unsigned, HashSet<String> > trigrams_;
+		/// Terms by their first character and first two characters, for short prefix queries.
+		HashMap<unsigned, HashSet<String> > leads_;
+		/// Held by event handlers while they update and by Find while it reads.
+		mutable Mutex mutex_;
+	};
+}
@@ -0,0 +1,184 @@
+#include "DevServerStats.h"
+
+#include "../Container/Sort.h"
+#include "../Core/Timer.h"
+#include "../Math/MathDefs.h"
+
+namespace Urho3D
+{
+
+	DevLatencyHistogram::DevLatencyHistogram() :
+		count_(0),
+		total_(0),
+		max_(0)
+	{
+		for (unsigned i = 0; i < NUM_BUCKETS; ++i)
+			buckets_[i].store(0, std::memory_order_relaxed);
+	}
+
+	unsigned DevLatencyHistogram::GetBucket(unsigned usec)
+	{
+		if (usec < SUB_BUCKETS)
+			return usec;
+
+		unsigned exponent = SUB_BUCKET_BITS;
+		while (exponent < 31 && (usec >> (exponent + 1)))
+			++exponent;
+		// the top SUB_BUCKET_BITS below the leading one pick the bucket within the power of two
+		const unsigned sub = (usec >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+		return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+	}
+
+	unsigned DevLatencyHistogram::GetBucketStart(unsigned bucket)
+	{
+		if (bucket < SUB_BUCKETS)
+			return bucket;
+		const unsigned exponent = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+		const unsigned sub = bucket % SUB_BUCKETS;
+		return (SUB_BUCKETS + sub) << (exponent - SUB_BUCKET_BITS);
+	}
+
+	void DevLatencyHistogram::Record(unsigned usec)
+	{
+		buckets_[GetBucket(usec)].fetch_add(1, std::memory_order_relaxed);
+		count_.fetch_add(1, std::memory_order_relaxed);
+		total_.fetch_add(usec, std::memory_order_relaxed);
+
+		unsigned longest = max_.load(std::memory_order_relaxed);
+		while (usec > longest && !max_.compare_exchange_weak(longest, usec, std::memory_order_relaxed))
+			;
+	}
+
+	void DevLatencyHistogram::Reset()
+	{
+		for (unsigned i = 0; i < NUM_BUCKETS; ++i)
+			buckets_[i].store(0, std::memory_order_relaxed);
+		count_.store(0, std::memory_order_relaxed);
+		total_.store(0, std::memory_order_relaxed);
+		max_.store(0, std::memory_order_relaxed);
+	}
+
+	float DevLatencyHistogram::GetMean() const
+	{
+		const unsigned long long count = GetCount();
+		return count ? (float)((double)GetTotal() / count) : 0.0f;
+	}
+
+	unsigned DevLatencyHistogram::GetPercentile(float fraction) const
+	{
+		// count from the buckets rather than count_ so a record landing mid-scan can't push the rank past the end
+		unsigned long long count = 0;
+		for (unsigned i = 0; i < NUM_BUCKETS; ++i)
+			count += buckets_[i].load(std::memory_order_relaxed);
+		if (!count)
+			return 0;
+
+		const unsigned long long rank = Max((unsigned long long)(Clamp(fraction, 0.0f, 1.0f) * count + 0.5), 1ull);
+		const unsigned longest = GetMax();
+		unsigned long long seen = 0;
+		for (unsigned i = 0; i < NUM_BUCKETS; ++i)
+		{
+			seen += buckets_[i].load(std::memory_order_relaxed);
+			if (seen >= rank)
+			{
+				// report the middle of the bucket, never more than the longest duration actually seen
+				const unsigned start = GetBucketStart(i);
+				const unsigned end = i + 1 < NUM_BUCKETS ? GetBucketStart(i + 1) : M_MAX_UNSIGNED;
+				const unsigned middle = start + (end - start) / 2;
+				return longest ? Min(middle, longest) : middle;
+			}
+		}
+		return longest;
+	}
+
+	DevEndpointStats::DevEndpointStats() :
+		bytes_(0),
+		notModified_(0)
+	{
+	}
+
+	DevServerStats::DevServerStats() :
+		startTime_(Time::GetSystemTime())
+	{
+	}
+
+	DevServerStats::~DevServerStats()
+	{
+		for (auto& endpoint : endpoints_)
+			delete endpoint.second_;
+	}
+
+	DevEndpointStats* DevServerStats::GetEndpoint(const String& endpoint)
+	{
+		MutexLock lock(endpointsMutex_);
+		DevEndpointStats*& stats = endpoints_[endpoint];
+		if (!stats)
+			stats = new DevEndpointStats();
+		return stats;
+	}
+
+	void DevServerStats::RecordRequest(const String& endpoint, const DevRequestTiming& timing)
+	{
+		DevEndpointStats* stats = GetEndpoint(endpoint);
+		stats->total_.Record(timing.total_);
+		stats->match_.Record(timing.match_);
+		if (timing.notModified_)
+		{
+			stats->notModified_.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		stats->emit_.Record(timing.emit_);
+		stats->write_.Record(timing.write_);
+		stats->bytes_.fetch_add(timing.bytes_, std::memory_order_relaxed);
+	}
+
+	void DevServerStats::Reset()
+	{
+		{
+			MutexLock lock(endpointsMutex_);
+			for (auto& endpoint : endpoints_)
+			{
+				DevEndpointStats* stats = endpoint.second_;
+				stats->match_.Reset();
+				stats->emit_.Reset();
+				stats->write_.Reset();
+				stats->total_.Reset();
+				stats->bytes_.store(0, std::memory_order_relaxed);
+				stats->notModified_.store(0, std::memory_order_relaxed);
+			}
+		}
+		frameCost_.Reset();
+		logCost_.Reset();
+		startTime_.store(Time::GetSystemTime(), std::memory_order_relaxed);
+	}
+
+	static bool CompareEndpointNames(const Pair<String, const DevEndpointStats*>& lhs, const Pair<String, const DevEndpointStats*>& rhs)
+	{
+		return lhs.first_ < rhs.first_;
+	}
+
+	void DevServerStats::GetEndpoints(Vector<Pair<String, const DevEndpointStats*> >& endpoints) const
+	{
+		{
+			MutexLock lock(endpointsMutex_);
+			endpoints.Reserve(endpoints_.Size());
+			for (const auto& endpoint : endpoints_)
+				endpoints.Push(MakePair(endpoint.first_, (const DevEndpointStats*)endpoint.second_));
+		}
+		Sort(endpoints.Begin(), endpoints.End(), CompareEndpointNames);
+	}
+
+	unsigned DevServerStats::GetElapsedTime() const
+	{
+		return Time::GetSystemTime() - startTime_.load(std::memory_order_relaxed);
+	}
+
+	float DevServerStats::GetMainThreadShare() const
+	{
+		const unsigned elapsed = GetElapsedTime();
+		if (!elapsed)
+			return 0.0f;
+		const double spent = (double)(frameCost_.GetTotal() + logCost_.GetTotal());
+		return (float)(spent / (elapsed * 1000.0));
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Container/Str.h"
+#include "../Container/Vector.h"
+#include "../Core/Mutex.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+	/// Histogram of microsecond durations with log-linear buckets, in the manner of HdrHistogram.
+	/// Values below SUB_BUCKETS are counted exactly, above that each power of two is split into SUB_BUCKETS equal buckets,
+	/// so any percentile is within 1/SUB_BUCKETS of the true value across the whole unsigned range.
+	/// Recording is a few relaxed atomic adds and safe from any thread; reads are a consistent-enough snapshot for display.
+	class URHO3D_API DevLatencyHistogram
+	{
+	public:
+		/// Bits of precision kept per power of two.
+		static const unsigned SUB_BUCKET_BITS = 4;
+		static const unsigned SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+		/// Exact buckets for 0..SUB_BUCKETS-1, then SUB_BUCKETS for each power of two up to 2^31.
+		static const unsigned NUM_BUCKETS = (32 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+		DevLatencyHistogram();
+
+		/// Records one duration. Any thread.
+		void Record(unsigned usec);
+		/// Clears the histogram, concurrent records may partly survive.
+		void Reset();
+
+		/// Number of durations recorded.
+		unsigned long long GetCount() const { return count_.load(std::memory_order_relaxed); }
+		/// Sum of all durations in microseconds.
+		unsigned long long GetTotal() const { return total_.load(std::memory_order_relaxed); }
+		/// Longest duration recorded.
+		unsigned GetMax() const { return max_.load(std::memory_order_relaxed); }
+		/// Average duration, 0 when empty.
+		float GetMean() const;
+		/// Duration at or below which the given fraction (0..1) of the records fall, 0 when empty.
+		unsigned GetPercentile(float fraction) const;
+
+		/// Returns the bucket a duration is counted in.
+		static unsigned GetBucket(unsigned usec);
+		/// Returns the smallest duration counted in a bucket.
+		static unsigned GetBucketStart(unsigned bucket);
+
+	private:
+		std::atomic<unsigned> buckets_[NUM_BUCKETS];
+		std::atomic<unsigned long long> count_;
+		std::atomic<unsigned long long> total_;
+		std::atomic<unsigned> max_;
+	};
+
+	/// Durations of one request, split by where the time went.
+	struct URHO3D_API DevRequestTiming {
+		DevRequestTiming() :
+			match_(0),
+			emit_(0),
+			write_(0),
+			total_(0),
+			bytes_(0),
+			notModified_(false)
+		{
+		}
+
+		/// Routing the URL and checking the ETag.
+		unsigned match_;
+		/// Generating the body, less the time spent writing it.
+		unsigned emit_;
+		/// Writing to the connection.
+		unsigned write_;
+		/// The whole request from BeginRequest to the last write.
+		unsigned total_;
+		/// Body bytes sent.
+		unsigned bytes_;
+		/// Answered with a 304.
+		bool notModified_;
+	};
+
+	/// Timings of every request answered by one endpoint.
+	struct URHO3D_API DevEndpointStats {
+		DevEndpointStats();
+
+		DevLatencyHistogram match_;
+		DevLatencyHistogram emit_;
+		DevLatencyHistogram write_;
+		DevLatencyHistogram total_;
+		std::atomic<unsigned long long> bytes_;
+		std::atomic<unsigned long long> notModified_;
+	};
+
+	/// DevServer's measurements of itself: request latency per endpoint and the time it takes from the main thread.
+	/// Endpoints are created on first use and never removed, so a pointer to one stays valid for the life of the stats.
+	class URHO3D_API DevServerStats
+	{
+	public:
+		DevServerStats();
+		~DevServerStats();
+
+		/// Records a finished request against an endpoint (a route pattern or static file). Any thread.
+		void RecordRequest(const String& endpoint, const DevRequestTiming& timing);
+		/// Records microseconds spent in the per-frame update. Main thread.
+		void RecordFrame(unsigned usec) { frameCost_.Record(usec); }
+		/// Records microseconds spent handling a log message. Main thread.
+		void RecordLog(unsigned usec) { logCost_.Record(usec); }
+		/// Clears every histogram, keeping the endpoints.
+		void Reset();
+
+		/// Returns the endpoints sorted by name.
+		void GetEndpoints(Vector<Pair<String, const DevEndpointStats*> >& endpoints) const;
+		/// Returns the cost of the per-frame update.
+		const DevLatencyHistogram& GetFrameCost() const { return frameCost_; }
+		/// Returns the cost of handling log messages.
+		const DevLatencyHistogram& GetLogCost() const { return logCost_; }
+		/// Returns the share of wall time (0..1) the main thread has spent in DevServer since the stats were created or reset.
+		float GetMainThreadShare() const;
+		/// Returns milliseconds since the stats were created or reset.
+		unsigned GetElapsedTime() const;
+
+	private:
+		DevEndpointStats* GetEndpoint(const String& endpoint);
+
+		HashMap<String, DevEndpointStats*> endpoints_;
+		mutable Mutex endpointsMutex_;
+		DevLatencyHistogram frameCost_;
+		DevLatencyHistogram logCost_;
+		std::atomic<unsigned> startTime_;
+	};
+}
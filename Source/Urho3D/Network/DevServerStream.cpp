@@ -0,0 +1,187 @@
+#include "DevServerStream.h"
+
+#include "../Core/StringUtils.h"
+#include "../Math/MathDefs.h"
+
+#include <chrono>
+
+namespace Urho3D
+{
+
+	DevServerStreamClient::DevServerStreamClient(const String& channel, unsigned capacity) :
+		channel_(channel),
+		skipThrough_(0),
+		head_(0),
+		count_(0),
+		dropped_(0),
+		totalDropped_(0),
+		closed_(false)
+	{
+		queue_.Resize(Max(capacity, 1u));
+	}
+
+	void DevServerStreamClient::Push(const Frame& frame, unsigned long long id)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (closed_ || (id && id <= skipThrough_))
+				return;
+
+			const unsigned capacity = queue_.Size();
+			if (count_ == capacity)
+			{
+				// drop-oldest, the slow reader loses history rather than stalling the producer
+				queue_[head_].frame_.reset();
+				head_ = (head_ + 1) % capacity;
+				--count_;
+				++dropped_;
+				++totalDropped_;
+			}
+			Entry& entry = queue_[(head_ + count_) % capacity];
+			entry.frame_ = frame;
+			entry.id_ = id;
+			++count_;
+		}
+		ready_.notify_one();
+	}
+
+	bool DevServerStreamClient::Wait(Vector<Frame>& frames, unsigned& dropped, unsigned timeoutMs)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		ready_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return closed_ || count_ > 0; });
+		if (closed_)
+			return false;
+
+		const unsigned capacity = queue_.Size();
+		for (; count_ > 0; --count_)
+		{
+			Entry& entry = queue_[head_];
+			if (!entry.id_ || entry.id_ > skipThrough_)
+				frames.Push(entry.frame_);
+			entry.frame_.reset();
+			head_ = (head_ + 1) % capacity;
+		}
+		dropped = dropped_;
+		dropped_ = 0;
+		return true;
+	}
+
+	void DevServerStreamClient::SkipThrough(unsigned long long id)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		skipThrough_ = Max(skipThrough_, id);
+	}
+
+	void DevServerStreamClient::Close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			closed_ = true;
+		}
+		ready_.notify_all();
+	}
+
+	DevServerStreamHub::DevServerStreamHub(unsigned queueCapacity) :
+		numClients_(0),
+		queueCapacity_(queueCapacity),
+		accepting_(true)
+	{
+	}
+
+	std::shared_ptr<DevServerStreamClient> DevServerStreamHub::Subscribe(const String& channel)
+	{
+		auto client = std::make_shared<DevServerStreamClient>(channel, queueCapacity_);
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!accepting_)
+			return nullptr;
+		clients_.Push(client);
+		numClients_.store(clients_.Size(), std::memory_order_relaxed);
+		return client;
+	}
+
+	void DevServerStreamHub::Unsubscribe(const std::shared_ptr<DevServerStreamClient>& client)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		clients_.Remove(client);
+		numClients_.store(clients_.Size(), std::memory_order_relaxed);
+	}
+
+	void DevServerStreamHub::Shutdown()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		accepting_ = false;
+		for (auto& client : clients_)
+			client->Close();
+		clients_.Clear();
+		numClients_.store(0, std::memory_order_relaxed);
+	}
+
+	void DevServerStreamHub::Resume()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		accepting_ = true;
+	}
+
+	bool DevServerStreamHub::HasClients(const String& channel) const
+	{
+		if (numClients_.load(std::memory_order_relaxed) == 0)
+			return false;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (const auto& client : clients_)
+		{
+			if (client->GetChannel() == channel)
+				return true;
+		}
+		return false;
+	}
+
+	void DevServerStreamHub::Broadcast(const String& channel, const char* event, const String& data, unsigned long long id)
+	{
+		if (numClients_.load(std::memory_order_relaxed) == 0)
+			return;
+
+		// formatted once, every client queues the same frame
+		DevServerStreamClient::Frame frame;
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (auto& client : clients_)
+		{
+			if (client->GetChannel() != channel)
+				continue;
+			if (!frame)
+				frame = std::make_shared<const String>(FormatEvent(event, data, id));
+			client->Push(frame, id);
+		}
+	}
+
+	String DevServerStreamHub::FormatEvent(const char* event, const String& data, unsigned long long id)
+	{
+		String ret;
+		ret.Reserve(data.Length() + 48);
+		if (id)
+			ret += ToString("id: %llu\n", id);
+		if (event && *event)
+		{
+			ret += "event: ";
+			ret += event;
+			ret += '\n';
+		}
+
+		unsigned start = 0;
+		while (true)
+		{
+			const unsigned end = data.Find('\n', start);
+			ret += "data: ";
+			if (end == String::NPOS)
+			{
+				ret.Append(data.CString() + start, data.Length() - start);
+				break;
+			}
+			ret.Append(data.CString() + start, end - start);
+			ret += '\n';
+			start = end + 1;
+		}
+		ret += "\n\n";
+		return ret;
+	}
+}
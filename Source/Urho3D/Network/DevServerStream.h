@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../Container/Str.h"
+#include "../Container/Vector.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace Urho3D
+{
+
+	/// One open Server-Sent Events connection, a bounded queue of formatted frames waiting to be written.
+	/// When the queue is full the oldest frame is dropped and counted so the producer never waits on a slow client.
+	class URHO3D_API DevServerStreamClient
+	{
+	public:
+		/// A formatted frame, shared by every client it was broadcast to.
+		typedef std::shared_ptr<const String> Frame;
+
+		DevServerStreamClient(const String& channel, unsigned capacity);
+
+		/// Queues a frame, dropping the oldest queued frame if full. Never blocks on the connection.
+		void Push(const Frame& frame, unsigned long long id = 0);
+		/// Waits up to timeoutMs for frames and moves everything queued into frames, also returns how many were dropped since the last call.
+		/// Returns false once the client has been closed.
+		bool Wait(Vector<Frame>& frames, unsigned& dropped, unsigned timeoutMs);
+		/// Discards queued and future frames with an id at or below id, for frames the writer already replayed from history.
+		void SkipThrough(unsigned long long id);
+		/// Wakes the writer and makes Wait return false.
+		void Close();
+
+		/// Channel the client subscribed to.
+		const String& GetChannel() const { return channel_; }
+		/// Frames dropped over the client's lifetime.
+		unsigned GetTotalDropped() const { return totalDropped_; }
+
+	private:
+		String channel_;
+		std::mutex mutex_;
+		std::condition_variable ready_;
+		struct Entry {
+			Frame frame_;
+			unsigned long long id_;
+		};
+		/// Ring of queued frames.
+		Vector<Entry> queue_;
+		unsigned long long skipThrough_;
+		unsigned head_;
+		unsigned count_;
+		unsigned dropped_;
+		unsigned totalDropped_;
+		bool closed_;
+	};
+
+	/// Fans events out to the Server-Sent Events clients of named channels.
+	/// Broadcast is called from the main thread and only touches in-memory queues, each connection is written by its own civetweb worker.
+	class URHO3D_API DevServerStreamHub
+	{
+	public:
+		/// Default number of frames a client may fall behind before the oldest are dropped.
+		static const unsigned DEFAULT_QUEUE_CAPACITY = 256;
+
+		DevServerStreamHub(unsigned queueCapacity = DEFAULT_QUEUE_CAPACITY);
+
+		/// Registers a new client for the channel, returns null while the hub is shut down.
+		std::shared_ptr<DevServerStreamClient> Subscribe(const String& channel);
+		/// Removes a client, called by its writer once the connection ends.
+		void Unsubscribe(const std::shared_ptr<DevServerStreamClient>& client);
+		/// Closes every client so their writers return and refuses new ones, must happen before stopping the server as each client holds a worker.
+		void Shutdown();
+		/// Accepts clients again after a Shutdown.
+		void Resume();
+
+		/// Returns true if anyone is listening on the channel, lets producers skip formatting.
+		bool HasClients(const String& channel) const;
+		/// Number of open clients over all channels.
+		unsigned GetNumClients() const { return numClients_.load(std::memory_order_relaxed); }
+
+		/// Queues an event for every client of the channel, id may be 0 for none.
+		void Broadcast(const String& channel, const char* event, const String& data, unsigned long long id = 0);
+
+		/// Formats one event in the text/event-stream framing, multi-line data is split into data: lines.
+		static String FormatEvent(const char* event, const String& data, unsigned long long id = 0);
+
+	private:
+		mutable std::mutex mutex_;
+		Vector<std::shared_ptr<DevServerStreamClient>> clients_;
+		std::atomic<unsigned> numClients_;
+		unsigned queueCapacity_;
+		bool accepting_;
+	};
+}
@@ -0,0 +1,384 @@
+#include "DevServerWatch.h"
+
+#include "../Core/StringUtils.h"
+#include "../Core/Timer.h"
+#include "../Math/MathDefs.h"
+#include "../Network/DevInspector.h"
+#include "../Network/DevServer.h"
+#include "../Network/DevServerJSON.h"
+#include "../Scene/Component.h"
+
+#include <Civetweb/civetweb.h>
+
+namespace Urho3D
+{
+
+	DevServerWatchHub::DevServerWatchHub(DevServer* server) :
+		server_(server),
+		stopping_(false)
+	{
+	}
+
+	DevServerWatchHub::~DevServerWatchHub()
+	{
+		// the server normally closes every connection first, this only catches writers it left behind
+		Vector<std::shared_ptr<Connection>> open;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+			for (auto& pair : connections_)
+			{
+				pair.second_->outboxReady_.notify_all();
+				open.Push(pair.second_);
+			}
+			connections_.Clear();
+		}
+		for (auto& connection : open)
+		{
+			if (connection->writer_.joinable())
+				connection->writer_.join();
+		}
+	}
+
+	void DevServerWatchHub::Install(struct mg_context* context)
+	{
+		mg_set_websocket_handler(context, "/Watch", OnConnect, OnReady, OnData, OnClose, this);
+	}
+
+	void DevServerWatchHub::Shutdown()
+	{
+		Vector<std::shared_ptr<Connection>> open;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (auto& pair : connections_)
+				open.Push(pair.second_);
+		}
+
+		// the close handshake ends civetweb's read loop so mg_stop doesn't wait on it
+		for (auto& connection : open)
+		{
+			std::lock_guard<std::mutex> lock(connection->writeMutex_);
+			if (!connection->closed_)
+				mg_websocket_write(connection->conn_, MG_WEBSOCKET_OPCODE_CONNECTION_CLOSE, "", 0);
+		}
+	}
+
+	unsigned DevServerWatchHub::GetNumConnections() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return connections_.Size();
+	}
+
+	int DevServerWatchHub::OnConnect(const struct mg_connection* conn, void* hub)
+	{
+		return 0;
+	}
+
+	void DevServerWatchHub::OnReady(struct mg_connection* conn, void* hub)
+	{
+		DevServerWatchHub* self = static_cast<DevServerWatchHub*>(hub);
+		auto connection = std::make_shared<Connection>(conn);
+		std::lock_guard<std::mutex> lock(self->mutex_);
+		self->connections_[conn] = connection;
+		connection->writer_ = std::thread(&DevServerWatchHub::WriterLoop, self, connection);
+	}
+
+	int DevServerWatchHub::OnData(struct mg_connection* conn, int bits, char* data, size_t length, void* hub)
+	{
+		const int opcode = bits & 0xf;
+		if (opcode == MG_WEBSOCKET_OPCODE_CONNECTION_CLOSE)
+			return 0;
+		if (opcode != MG_WEBSOCKET_OPCODE_TEXT)
+			return 1;
+
+		DevServerWatchHub* self = static_cast<DevServerWatchHub*>(hub);
+		std::shared_ptr<Connection> connection;
+		{
+			std::lock_guard<std::mutex> lock(self->mutex_);
+			auto found = self->connections_.Find(conn);
+			if (found == self->connections_.End())
+				return 0;
+			connection = found->second_;
+		}
+
+		Vector<Request> parsed;
+		const Vector<String> lines = String(data, (unsigned)length).Split('\n');
+		for (const auto& line : lines)
+		{
+			Request request;
+			request.connection_ = connection;
+			if (ParseRequest(line, request))
+				parsed.Push(request);
+		}
+
+		std::lock_guard<std::mutex> lock(self->mutex_);
+		self->requests_.Push(parsed);
+		return 1;
+	}
+
+	void DevServerWatchHub::OnClose(const struct mg_connection* conn, void* hub)
+	{
+		DevServerWatchHub* self = static_cast<DevServerWatchHub*>(hub);
+		std::shared_ptr<Connection> connection;
+		{
+			std::lock_guard<std::mutex> lock(self->mutex_);
+			auto found = self->connections_.Find(conn);
+			if (found == self->connections_.End())
+				return;
+			connection = found->second_;
+			self->connections_.Erase(found);
+		}
+
+		// waits out a write in progress, civetweb frees the connection once this returns
+		{
+			std::lock_guard<std::mutex> lock(connection->writeMutex_);
+			connection->closed_ = true;
+		}
+		{
+			std::lock_guard<std::mutex> lock(self->mutex_);
+			connection->outboxReady_.notify_all();
+		}
+		if (connection->writer_.joinable())
+			connection->writer_.join();
+	}
+
+	bool DevServerWatchHub::ParseRequest(const String& line, Request& request)
+	{
+		const Vector<String> fields = line.Trimmed().Split('\t', true);
+		if (fields.Size() < 4)
+			return false;
+
+		request.verb_ = fields[0].ToLower();
+		request.scene_ = fields[1];
+		request.kind_ = fields[2];
+		request.id_ = ToUInt(fields[3]);
+		request.rate_ = DEFAULT_RATE;
+
+		if (request.verb_ == "watch")
+		{
+			if (fields.Size() > 4)
+				request.rate_ = Clamp(ToUInt(fields[4]), 1u, MAX_RATE);
+			return true;
+		}
+		if (request.verb_ == "unwatch")
+			return true;
+		if (request.verb_ == "set" && fields.Size() > 5)
+		{
+			request.attribute_ = fields[4];
+			// the value is the rest of the line, it may contain tabs of its own
+			request.value_ = fields[5];
+			for (unsigned i = 6; i < fields.Size(); ++i)
+				request.value_ += "\t" + fields[i];
+			return true;
+		}
+		return false;
+	}
+
+	Serializable* DevServerWatchHub::FindTarget(Scene* scene, const String& kind, unsigned id)
+	{
+		if (!scene)
+			return nullptr;
+		if (kind.Compare("Node", false) == 0)
+			return scene->GetNode(id);
+		if (kind.Compare("Component", false) == 0)
+			return scene->GetComponent(id);
+		return nullptr;
+	}
+
+	void DevServerWatchHub::Update()
+	{
+		Vector<Request> requests;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			requests.Swap(requests_);
+		}
+		for (const auto& request : requests)
+			ApplyRequest(request);
+
+		if (watches_.Empty())
+			return;
+
+		// connections whose outbox overflowed get full state on their watches' next tick
+		PODVector<Connection*> resyncing;
+		for (auto& watch : watches_)
+		{
+			if (watch.connection_->resync_.exchange(false))
+				resyncing.Push(watch.connection_.get());
+		}
+
+		const unsigned now = Time::GetSystemTime();
+		for (unsigned i = 0; i < watches_.Size();)
+		{
+			Watch& watch = watches_[i];
+			if (watch.connection_->closed_)
+			{
+				watches_.Erase(i);
+				continue;
+			}
+
+			const bool full = resyncing.Contains(watch.connection_.get());
+			if (!full && (int)(now - watch.nextMs_) < 0)
+			{
+				++i;
+				continue;
+			}
+
+			watch.nextMs_ = now + watch.intervalMs_;
+			if (SendDelta(watch, full))
+				++i;
+			else
+				watches_.Erase(i);
+		}
+	}
+
+	void DevServerWatchHub::ApplyRequest(const Request& request)
+	{
+		if (request.connection_->closed_)
+			return;
+
+		Scene* scene = server_->FindScene(request.scene_);
+		if (request.verb_ == "watch")
+		{
+			for (auto& watch : watches_)
+			{
+				// re-watching only changes the rate
+				if (watch.connection_ == request.connection_ && watch.scene_.Get() == scene && watch.id_ == request.id_ && watch.kind_.Compare(request.kind_, false) == 0)
+				{
+					watch.intervalMs_ = 1000 / request.rate_;
+					return;
+				}
+			}
+
+			Watch watch;
+			watch.connection_ = request.connection_;
+			watch.scene_ = scene;
+			watch.sceneName_ = request.scene_;
+			watch.kind_ = request.kind_;
+			watch.id_ = request.id_;
+			watch.intervalMs_ = 1000 / request.rate_;
+			watch.nextMs_ = Time::GetSystemTime() + watch.intervalMs_;
+			if (SendDelta(watch, true))
+				watches_.Push(watch);
+		}
+		else if (request.verb_ == "unwatch")
+		{
+			for (unsigned i = 0; i < watches_.Size(); ++i)
+			{
+				const Watch& watch = watches_[i];
+				if (watch.connection_ == request.connection_ && watch.scene_.Get() == scene && watch.id_ == request.id_ && watch.kind_.Compare(request.kind_, false) == 0)
+				{
+					watches_.Erase(i);
+					break;
+				}
+			}
+		}
+		else if (request.verb_ == "set")
+		{
+			Serializable* target = FindTarget(scene, request.kind_, request.id_);
+			if (!target || !SetAttributeFromString(target, request.attribute_, request.value_))
+			{
+				DevServerJSONWriter writer;
+				writer.BeginObject();
+				writer.Key("error");
+				writer.Value(ToString("Cannot set %s on %s %u", request.attribute_.CString(), request.kind_.CString(), request.id_));
+				writer.EndObject();
+				Enqueue(request.connection_, writer.GetBuffer());
+			}
+		}
+	}
+
+	bool DevServerWatchHub::SendDelta(Watch& watch, bool full)
+	{
+		Serializable* target = FindTarget(watch.scene_.Get(), watch.kind_, watch.id_);
+
+		DevServerJSONWriter writer(256);
+		writer.BeginObject();
+		writer.Key("scene");
+		writer.Value(watch.sceneName_);
+		writer.Key("kind");
+		writer.Value(watch.kind_);
+		writer.Key("id");
+		writer.Value(watch.id_);
+		if (!target)
+		{
+			writer.Key("removed");
+			writer.Value(true);
+			writer.EndObject();
+			Enqueue(watch.connection_, writer.GetBuffer());
+			return false;
+		}
+
+		writer.Key("full");
+		writer.Value(full);
+		writer.Key("attrs");
+		writer.BeginObject();
+		unsigned changed = 0;
+		if (const Vector<AttributeInfo>* attrs = target->GetAttributes())
+		{
+			for (unsigned i = 0; i < attrs->Size(); ++i)
+			{
+				const AttributeInfo& attr = (*attrs)[i];
+				if (attr.mode_ & AM_NOEDIT)
+					continue;
+
+				const String value = VarToString(target->GetAttribute(i), target->GetContext());
+				auto sent = watch.sent_.Find(attr.name_);
+				if (sent != watch.sent_.End())
+				{
+					if (!full && sent->second_ == value)
+						continue;
+					sent->second_ = value;
+				}
+				else
+					watch.sent_.Insert(MakePair(attr.name_, value));
+
+				writer.Key(attr.name_);
+				writer.Value(value);
+				++changed;
+			}
+		}
+		writer.EndObject();
+		writer.EndObject();
+
+		if (changed || full)
+			Enqueue(watch.connection_, writer.GetBuffer());
+		return true;
+	}
+
+	void DevServerWatchHub::Enqueue(const std::shared_ptr<Connection>& connection, const String& frame)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (connection->outbox_.Size() >= OUTBOX_CAPACITY)
+			{
+				connection->outbox_.Clear();
+				connection->resync_ = true;
+			}
+			connection->outbox_.Push(frame);
+		}
+		connection->outboxReady_.notify_one();
+	}
+
+	void DevServerWatchHub::WriterLoop(std::shared_ptr<Connection> connection)
+	{
+		Vector<String> frames;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				connection->outboxReady_.wait(lock, [this, &connection] { return stopping_ || connection->closed_ || !connection->outbox_.Empty(); });
+				if (stopping_ || connection->closed_)
+					return;
+				frames.Swap(connection->outbox_);
+			}
+
+			std::lock_guard<std::mutex> lock(connection->writeMutex_);
+			for (const auto& frame : frames)
+			{
+				if (connection->closed_ || mg_websocket_write(connection->conn_, MG_WEBSOCKET_OPCODE_TEXT, frame.CString(), frame.Length()) <= 0)
+					break;
+			}
+			frames.Clear();
+		}
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Container/Ptr.h"
+#include "../Container/Str.h"
+#include "../Container/Vector.h"
+#include "../Scene/Scene.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+struct mg_connection;
+struct mg_context;
+
+namespace Urho3D
+{
+	class DevServer;
+	class Serializable;
+
+	/// Live attribute watching and editing over a WebSocket at /Watch.
+	/// Clients send tab-separated text lines:
+	///		- watch <scene> <Node|Component> <id> [rate], pushes the target's attributes, then only the changed ones up to rate times a second
+	///		- unwatch <scene> <Node|Component> <id>
+	///		- set <scene> <Node|Component> <id> <attribute> <value>, applies an edit on the main thread
+	/// and receive JSON objects { "scene", "kind", "id", "full", "attrs": { name: value } }, or { ..., "removed": true } when the target goes away.
+	/// Requests are parsed on the civetweb worker, watches are evaluated on the main thread in Update,
+	/// and every connection has its own writer thread sending the results, so a slow client never blocks the frame or the other clients.
+	class URHO3D_API DevServerWatchHub
+	{
+	public:
+		/// Watch rate used when the client doesn't ask for one.
+		static const unsigned DEFAULT_RATE = 10;
+		/// Fastest rate a watch may request.
+		static const unsigned MAX_RATE = 60;
+		/// Frames a client may fall behind before its outbox is discarded and it's resent full state.
+		static const unsigned OUTBOX_CAPACITY = 64;
+
+		DevServerWatchHub(DevServer* server);
+		~DevServerWatchHub();
+
+		/// Registers the /Watch handlers with a freshly started server.
+		void Install(struct mg_context* context);
+		/// Closes every connection, call before stopping the server.
+		void Shutdown();
+		/// Applies queued requests and pushes due deltas, main thread only.
+		void Update();
+
+		/// Number of open connections.
+		unsigned GetNumConnections() const;
+
+	private:
+		/// An open socket, shared by the civetweb callbacks, the main thread and its writer.
+		struct Connection {
+			Connection(struct mg_connection* conn) : conn_(conn), closed_(false), resync_(false) { }
+
+			struct mg_connection* conn_;
+			/// Held while writing so the close callback can't free the connection mid-write.
+			std::mutex writeMutex_;
+			/// Set under writeMutex_ once civetweb closes the socket, read without it by the main thread.
+			std::atomic<bool> closed_;
+			/// Frames waiting for the writer, guarded by the hub mutex.
+			Vector<String> outbox_;
+			/// The outbox overflowed, watches must resend their full state.
+			std::atomic<bool> resync_;
+			/// Signalled under the hub mutex when frames are queued or the connection closes.
+			std::condition_variable outboxReady_;
+			/// Runs WriterLoop for this connection, joined by the close callback.
+			std::thread writer_;
+		};
+
+		/// A request line parsed off the socket, applied in Update.
+		struct Request {
+			std::shared_ptr<Connection> connection_;
+			String verb_;
+			String scene_;
+			String kind_;
+			unsigned id_;
+			unsigned rate_;
+			String attribute_;
+			String value_;
+		};
+
+		/// One subscribed node or component, main thread only.
+		struct Watch {
+			std::shared_ptr<Connection> connection_;
+			WeakPtr<Scene> scene_;
+			String sceneName_;
+			String kind_;
+			unsigned id_;
+			unsigned intervalMs_;
+			unsigned nextMs_;
+			/// Attribute values as last sent.
+			HashMap<String, String> sent_;
+		};
+
+		static int OnConnect(const struct mg_connection* conn, void* hub);
+		static void OnReady(struct mg_connection* conn, void* hub);
+		static int OnData(struct mg_connection* conn, int bits, char* data, size_t length, void* hub);
+		static void OnClose(const struct mg_connection* conn, void* hub);
+
+		/// Parses a request line, returns false for anything malformed.
+		static bool ParseRequest(const String& line, Request& request);
+		/// Resolves a watch or request target to its node or component.
+		static Serializable* FindTarget(Scene* scene, const String& kind, unsigned id);
+
+		void ApplyRequest(const Request& request);
+		/// Writes the attributes that changed since the last send (all of them when full), returns false if the target is gone.
+		bool SendDelta(Watch& watch, bool full);
+		/// Queues a frame for the writer, dropping the backlog of a client that fell too far behind.
+		void Enqueue(const std::shared_ptr<Connection>& connection, const String& frame);
+		/// Sends a connection's outbox until it closes, a blocking write only holds up its own client.
+		void WriterLoop(std::shared_ptr<Connection> connection);
+
+		DevServer* server_;
+		mutable std::mutex mutex_;
+		/// Open connections keyed by civetweb connection.
+		HashMap<const struct mg_connection*, std::shared_ptr<Connection>> connections_;
+		/// Requests waiting for the main thread.
+		Vector<Request> requests_;
+		/// Active watches, main thread only.
+		Vector<Watch> watches_;
+		bool stopping_;
+	};
+}
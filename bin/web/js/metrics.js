@@ -0,0 +1,129 @@
+// Charts for the /Metrics page: one canvas per channel, polled as min/max/avg buckets sized to the canvas.
+(function () {
+    var root = document.getElementById('metrics');
+    if (!root)
+        return;
+
+    var charts = {};
+    var windowMs = +root.getAttribute('data-window') || 60000;
+    var POLL_MS = 500;
+    var CHANNELS_POLL_MS = 2000;
+
+    function formatValue(v) {
+        if (v === null || v === undefined)
+            return '-';
+        var a = Math.abs(v);
+        if (a >= 1e6 || (a > 0 && a < 1e-3))
+            return v.toExponential(2);
+        return a >= 100 ? v.toFixed(0) : v.toFixed(a >= 10 ? 1 : 3);
+    }
+
+    function addChart(channel) {
+        var panel = document.createElement('div');
+        panel.className = 'card mb-3';
+        panel.innerHTML =
+            '<div class="card-header"><b></b> <small class="text-muted"></small><span class="float-right"></span></div>' +
+            '<div class="card-body p-2"><canvas height="120" style="width:100%;height:120px"></canvas></div>';
+        panel.querySelector('b').textContent = channel.name;
+        panel.querySelector('small').textContent = channel.kind;
+        root.appendChild(panel);
+
+        charts[channel.name] = {
+            name: channel.name,
+            canvas: panel.querySelector('canvas'),
+            stats: panel.querySelector('.float-right'),
+            busy: false
+        };
+    }
+
+    function draw(chart, data) {
+        var canvas = chart.canvas;
+        var width = canvas.clientWidth;
+        if (canvas.width !== width)
+            canvas.width = width;
+        var height = canvas.height;
+        var ctx = canvas.getContext('2d');
+        ctx.clearRect(0, 0, width, height);
+
+        // raw samples are drawn as buckets of one
+        var buckets = data.buckets || data.samples.map(function (s) { return [s[2], s[3], s[3], s[3], 1]; });
+        if (!buckets.length) {
+            chart.stats.textContent = 'no samples';
+            return;
+        }
+
+        var lo = Infinity, hi = -Infinity, sum = 0, count = 0;
+        buckets.forEach(function (b) {
+            lo = Math.min(lo, b[1]);
+            hi = Math.max(hi, b[2]);
+            sum += b[3] * b[4];
+            count += b[4];
+        });
+        if (hi === lo) {
+            hi += 0.5;
+            lo -= 0.5;
+        }
+
+        var end = data.now;
+        var start = end - windowMs;
+        var pad = 4;
+        function x(t) { return (t - start) / windowMs * width; }
+        function y(v) { return pad + (hi - v) / (hi - lo) * (height - pad * 2); }
+
+        // min-max band behind the average line
+        ctx.fillStyle = 'rgba(0, 123, 255, 0.2)';
+        ctx.beginPath();
+        buckets.forEach(function (b, i) { i ? ctx.lineTo(x(b[0]), y(b[2])) : ctx.moveTo(x(b[0]), y(b[2])); });
+        for (var i = buckets.length - 1; i >= 0; --i)
+            ctx.lineTo(x(buckets[i][0]), y(buckets[i][1]));
+        ctx.closePath();
+        ctx.fill();
+
+        ctx.strokeStyle = 'rgb(0, 123, 255)';
+        ctx.lineWidth = 1.5;
+        ctx.beginPath();
+        buckets.forEach(function (b, i) { i ? ctx.lineTo(x(b[0]), y(b[3])) : ctx.moveTo(x(b[0]), y(b[3])); });
+        ctx.stroke();
+
+        ctx.fillStyle = '#6c757d';
+        ctx.font = '10px sans-serif';
+        ctx.fillText(formatValue(hi), 2, 10);
+        ctx.fillText(formatValue(lo), 2, height - 2);
+
+        var last = buckets[buckets.length - 1];
+        chart.stats.textContent = 'last ' + formatValue(last[3]) + '  min ' + formatValue(lo) + '  max ' + formatValue(hi) + '  avg ' + formatValue(sum / count);
+    }
+
+    function poll(chart) {
+        if (chart.busy)
+            return;
+        chart.busy = true;
+        var url = '/Metrics/Samples/' + encodeURIComponent(chart.name) + '?window=' + windowMs + '&points=' + Math.max(chart.canvas.clientWidth, 1);
+        $.getJSON(url).done(function (data) { draw(chart, data); }).always(function () { chart.busy = false; });
+    }
+
+    function pollChannels() {
+        $.getJSON('/Metrics/Channels').done(function (data) {
+            data.channels.forEach(function (channel) {
+                if (!charts[channel.name])
+                    addChart(channel);
+            });
+            var empty = document.getElementById('metricsEmpty');
+            if (empty)
+                empty.style.display = data.channels.length ? 'none' : '';
+        });
+    }
+
+    $('#metricsWindow').on('change', function () {
+        windowMs = +this.value;
+        Object.keys(charts).forEach(function (name) { poll(charts[name]); });
+    });
+
+    pollChannels();
+    setInterval(pollChannels, CHANNELS_POLL_MS);
+    setInterval(function () {
+        if (document.hidden)
+            return;
+        Object.keys(charts).forEach(function (name) { poll(charts[name]); });
+    }, POLL_MS);
+})();
@@ -0,0 +1,147 @@
+// The /Profiler view: frame times with the slow ones marked, a flame chart of a picked frame and per-block statistics.
+(function () {
+    var framesCanvas = document.getElementById('profilerFrames');
+    if (!framesCanvas)
+        return;
+
+    var flameCanvas = document.getElementById('profilerFlame');
+    var thresholdInput = document.getElementById('profilerThreshold');
+    var pauseInput = document.getElementById('profilerPause');
+    var frames = [];
+    var cursor = 0;
+    var selected = null;
+    var MAX_FRAMES = 300;
+    var POLL_MS = 1000;
+    var FLAME_ROW = 18;
+
+    function ms(us) { return (us / 1000).toFixed(2) + ' ms'; }
+    function thresholdUs() { return (+thresholdInput.value || 0) * 1000; }
+
+    function drawFrames() {
+        var width = framesCanvas.clientWidth;
+        if (framesCanvas.width !== width)
+            framesCanvas.width = width;
+        var height = framesCanvas.height;
+        var ctx = framesCanvas.getContext('2d');
+        ctx.clearRect(0, 0, width, height);
+        if (!frames.length)
+            return;
+
+        var limit = thresholdUs();
+        var top = Math.max(limit * 1.5, Math.max.apply(null, frames.map(function (f) { return f[2]; })));
+        var barWidth = width / MAX_FRAMES;
+        var offset = MAX_FRAMES - frames.length;
+        frames.forEach(function (f, i) {
+            var h = Math.max(1, f[2] / top * height);
+            ctx.fillStyle = f === selected ? '#343a40' : (limit && f[2] > limit ? '#dc3545' : '#28a745');
+            ctx.fillRect((offset + i) * barWidth, height - h, Math.max(1, barWidth - 1), h);
+        });
+
+        if (limit) {
+            var y = height - limit / top * height;
+            ctx.strokeStyle = '#dc3545';
+            ctx.setLineDash([4, 4]);
+            ctx.beginPath();
+            ctx.moveTo(0, y);
+            ctx.lineTo(width, y);
+            ctx.stroke();
+            ctx.setLineDash([]);
+        }
+    }
+
+    function drawFlame(data) {
+        var rows = 1;
+        data.nodes.forEach(function (n) { rows = Math.max(rows, n[1] + 1); });
+        var width = flameCanvas.clientWidth;
+        flameCanvas.width = width;
+        flameCanvas.height = rows * FLAME_ROW;
+        flameCanvas.style.height = flameCanvas.height + 'px';
+
+        var ctx = flameCanvas.getContext('2d');
+        var total = Math.max(data.time, 1);
+        var limit = thresholdUs();
+        ctx.font = '11px sans-serif';
+        ctx.textBaseline = 'middle';
+        data.nodes.forEach(function (n) {
+            var x = n[2] / total * width;
+            var w = n[3] / total * width;
+            if (w < 0.5)
+                return;
+            var y = n[1] * FLAME_ROW;
+            // hotter colours for blocks that take a larger share of the budget
+            var share = limit ? Math.min(n[3] / limit, 1) : 0;
+            ctx.fillStyle = 'hsl(' + Math.round(50 - share * 50) + ', 85%, ' + Math.round(70 - share * 15) + '%)';
+            ctx.fillRect(x, y, w - 1, FLAME_ROW - 1);
+            if (w > 40) {
+                ctx.fillStyle = '#212529';
+                var label = n[0] + ' ' + ms(n[3]) + (n[4] > 1 ? ' x' + n[4] : '');
+                ctx.save();
+                ctx.beginPath();
+                ctx.rect(x, y, w - 1, FLAME_ROW - 1);
+                ctx.clip();
+                ctx.fillText(label, x + 3, y + FLAME_ROW / 2);
+                ctx.restore();
+            }
+        });
+
+        document.getElementById('profilerFrameTitle').textContent = 'Frame ' + data.frame + ' - ' + ms(data.time) + (data.truncated ? ' (truncated)' : '');
+    }
+
+    function drawBlocks(data) {
+        // rebuild the tree so children follow their parent whatever order blocks were first seen in
+        var children = {};
+        data.blocks.forEach(function (b) { (children[b[1]] = children[b[1]] || []).push(b); });
+        var body = document.getElementById('profilerBlocks');
+        var rows = [];
+        (function walk(parent) {
+            (children[parent] || []).forEach(function (b) {
+                var cells = [b[2], b[4], b[5].toFixed(1), ms(b[6]), ms(b[7]), ms(b[8])];
+                var row = document.createElement('tr');
+                cells.forEach(function (c, i) {
+                    var cell = document.createElement('td');
+                    cell.textContent = c;
+                    if (i === 0)
+                        cell.style.paddingLeft = (0.3 + b[3] * 1.2) + 'em';
+                    row.appendChild(cell);
+                });
+                rows.push(row);
+                walk(b[0]);
+            });
+        })(-1);
+        body.innerHTML = '';
+        rows.forEach(function (r) { body.appendChild(r); });
+    }
+
+    function showCaptureCost(capture) {
+        document.getElementById('profilerCapture').textContent = 'capture cost avg ' + capture.avg.toFixed(1) + ' us, max ' + capture.max + ' us';
+    }
+
+    function poll() {
+        if (pauseInput.checked || document.hidden)
+            return;
+        $.getJSON('/Profiler/Frames?since=' + cursor).done(function (data) {
+            cursor = data.next;
+            frames = frames.concat(data.frames).slice(-MAX_FRAMES);
+            showCaptureCost(data.capture);
+            drawFrames();
+        });
+        $.getJSON('/Profiler/Blocks').done(drawBlocks);
+    }
+
+    framesCanvas.addEventListener('click', function (e) {
+        var barWidth = framesCanvas.clientWidth / MAX_FRAMES;
+        var index = Math.floor(e.offsetX / barWidth) - (MAX_FRAMES - frames.length);
+        if (index < 0 || index >= frames.length)
+            return;
+        selected = frames[index];
+        pauseInput.checked = true;
+        drawFrames();
+        $.getJSON('/Profiler/Frame/' + selected[0]).done(drawFlame).fail(function () {
+            document.getElementById('profilerFrameTitle').textContent = 'Frame ' + selected[1] + ' has already left the ring';
+        });
+    });
+    thresholdInput.addEventListener('input', drawFrames);
+
+    poll();
+    setInterval(poll, POLL_MS);
+})();
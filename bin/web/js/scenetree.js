@@ -0,0 +1,88 @@
+// The /Scenes/<scene> tree: nodes are expanded on demand and their children fetched a page at a time.
+(function () {
+    var root = document.getElementById('sceneTree');
+    if (!root)
+        return;
+
+    var scene = root.getAttribute('data-scene');
+    var base = '/Scenes/' + encodeURIComponent(scene);
+    var PAGE_SIZE = 200;
+
+    function message(list, text) {
+        var item = document.createElement('li');
+        item.className = 'text-muted';
+        item.textContent = text;
+        list.appendChild(item);
+    }
+
+    // children are [id, name, children, components, temporary]
+    function addNode(list, child) {
+        var item = document.createElement('li');
+        if (child[2] > 0) {
+            var toggle = document.createElement('a');
+            toggle.href = '#';
+            toggle.className = 'text-monospace mr-1';
+            toggle.textContent = '+';
+            var sublist = null;
+            toggle.addEventListener('click', function (e) {
+                e.preventDefault();
+                if (!sublist) {
+                    sublist = document.createElement('ul');
+                    item.appendChild(sublist);
+                    load(sublist, child[0], 0);
+                    toggle.textContent = '-';
+                    return;
+                }
+                var hidden = sublist.style.display === 'none';
+                sublist.style.display = hidden ? '' : 'none';
+                toggle.textContent = hidden ? '-' : '+';
+            });
+            item.appendChild(toggle);
+        }
+
+        var link = document.createElement('a');
+        link.href = base + '/Node/' + child[0];
+        link.textContent = child[1] + ' [' + child[0] + ']' + (child[4] ? ' (temporary)' : '');
+        item.appendChild(link);
+
+        if (child[2] > 0) {
+            var count = document.createElement('small');
+            count.className = 'text-muted ml-1';
+            count.textContent = child[2] + (child[2] === 1 ? ' child' : ' children');
+            item.appendChild(count);
+        }
+        list.appendChild(item);
+    }
+
+    // id is null for the scene itself
+    function load(list, id, offset) {
+        var url = base + '/Children' + (id === null ? '' : '/' + id) + '?offset=' + offset + '&limit=' + PAGE_SIZE;
+        $.getJSON(url).done(function (data) {
+            data.children.forEach(function (child) { addNode(list, child); });
+
+            var shown = data.offset + data.children.length;
+            if (shown < data.total) {
+                var more = document.createElement('li');
+                var link = document.createElement('a');
+                link.href = '#';
+                link.textContent = 'show more (' + (data.total - shown) + ' left)';
+                link.addEventListener('click', function (e) {
+                    e.preventDefault();
+                    list.removeChild(more);
+                    load(list, id, shown);
+                });
+                more.appendChild(link);
+                list.appendChild(more);
+            }
+            else if (!data.total && id === null)
+                message(list, 'The scene is empty');
+        }).fail(function (xhr) {
+            // a missing node (404) or a busy main thread (503) comes with its reason
+            message(list, xhr.responseJSON && xhr.responseJSON.error ? xhr.responseJSON.error : 'Failed to load');
+        });
+    }
+
+    var list = document.createElement('ul');
+    root.appendChild(list);
+    load(list, null, 0);
+})();
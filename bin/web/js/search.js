@@ -0,0 +1,53 @@
+// The /Search page: results follow the query as it's typed, a short pause after the last key sends it.
+(function () {
+    var input = document.getElementById('searchQuery');
+    var list = document.getElementById('searchResults');
+    if (!input || !list)
+        return;
+
+    var DELAY_MS = 250;
+    var timer = null;
+    var latest = 0;
+
+    function show(data) {
+        list.innerHTML = '';
+        data.results.forEach(function (result) {
+            var item = document.createElement('li');
+            var link = document.createElement('a');
+            link.href = result.url;
+            link.textContent = result.title;
+            item.appendChild(link);
+            list.appendChild(item);
+        });
+        if (data.query.trim() && !data.results.length) {
+            var none = document.createElement('li');
+            none.className = 'text-muted';
+            none.textContent = 'Nothing found';
+            list.appendChild(none);
+        }
+        if (data.truncated) {
+            var more = document.createElement('li');
+            more.className = 'text-muted';
+            more.textContent = 'Showing the first ' + data.results.length + ', add terms to narrow it down';
+            list.appendChild(more);
+        }
+    }
+
+    function query() {
+        var q = input.value;
+        // answers can arrive out of order, only the newest one is shown
+        var request = ++latest;
+        $.getJSON('/Search', { q: q, format: 'json' }).done(function (data) {
+            if (request !== latest)
+                return;
+            show(data);
+            history.replaceState(null, '', '/Search' + (q ? '?q=' + encodeURIComponent(q) : ''));
+        });
+    }
+
+    input.addEventListener('input', function () {
+        clearTimeout(timer);
+        timer = setTimeout(query, DELAY_MS);
+    });
+    input.focus();
+})();